@@ -6,7 +6,18 @@
 
 static Task* get_rdy_task();
 static void timer_running_func(void* param);
+static void timer_service_func(void* param);
+static void defer_running_func(void* param);
 static void idle_running_func(void* param);
+static void wait_timeout_func(void* param);
+static void hand_over_mutex(Mutex* p_mutex);
+static void serve_sem(Sem* p_sem, u32 count);
+STATUS set_task_prio(Task* p_task, u8 prio);
+STATUS create_timer(Timer* p_timer, u32 val, void(*func)(void*), void* param);
+STATUS create_periodic_timer(Timer* p_timer, u32 val, u32 period, void(*func)(void*), void* param);
+STATUS set_timer_hard(Timer* p_timer, u8 hard);
+STATUS activate_timer(Timer* p_timer);
+STATUS deactivate_timer(Timer* p_timer);
 
 // list function
 
@@ -43,19 +54,49 @@ static  void list_delete(ListNode* node) {
 
 EXTERN u32 g_irq;
 
-static u32 g_sched_lock;
+static u32 g_sched_lock[OS_CPU_NUM];
 EXTERN u32 g_running;
+EXTERN u32 g_rdy_lock;
 
 EXTERN Task* current_task;
 EXTERN Task* sched_task;
 
-static ListNode g_run_queue;
+static ListNode g_run_queue[PRIO_NUM];
+static u32 g_rdy_bitmap;
+
+static Task* g_edf_heap[EDF_TASK_NUM];
+static u32 g_edf_count;
+static u32 g_edf_util;
 
 static u64 g_tick;
 static Sem timer_sem;
 static ListNode g_timer;
+static u32 g_timer_lock;
+static u32 g_timer_wake;
+static u64 g_timer_due;
+EXTERN u32 g_timer_wakeup;
 static Task timer_task;
 static u8 timer_stack[1024];
+static ListNode g_hard_timer;
+static u32 g_hard_timer_lock;
+
+// deferred isr work, isr side reserves slots with ATOMIC_CAS on the head,
+// the defer task is the only consumer. the slot fields are shared with the
+// isr without a lock, so they are volatile
+
+typedef struct _Defer {
+
+	void (* volatile func)(void*);
+	void* volatile param;
+}Defer;
+
+static Defer g_defer[DEFER_NUM];
+static u32 g_defer_head;
+static u32 g_defer_tail;
+static u32 g_defer_wake;
+static Sem defer_sem;
+static Task defer_task;
+static u8 defer_stack[1024];
 
 static u64 g_idle;
 static Task idle_task;
@@ -65,32 +106,69 @@ static u8 idle_stack[1024];
 
 void os_init() {
 
+	u32 i;
+
 	// about irq
 
 	g_irq = 0;
 
 	// about schedule variable
 
-	g_sched_lock = 0;
+	for(i = 0; i < OS_CPU_NUM; i ++) {
+
+		g_sched_lock[i] = 0;
+	}
+
 	g_running = 0;
+	g_rdy_lock = 0;
 	current_task = NULL;
 	sched_task = NULL;
 
 	// about ready queue
 
-	list_init(&g_run_queue);
+	for(i = 0; i < PRIO_NUM; i ++) {
+
+		list_init(&g_run_queue[i]);
+	}
+
+	g_rdy_bitmap = 0;
+
+	g_edf_count = 0;
+	g_edf_util = 0;
 
 	// about timer task
 
 	g_tick = 0;
 	list_init(&g_timer);
+	g_timer_lock = 0;
+	g_timer_wake = 0;
+	g_timer_due = TIMER_IDLE;
+	g_timer_wakeup = 0;
+	list_init(&g_hard_timer);
+	g_hard_timer_lock = 0;
 	create_sem(&timer_sem, 0);
 	create_task(&timer_task, timer_running_func, NULL, timer_stack, 1024);
+	set_task_prio(&timer_task, TIMER_PRIO);
+
+	// about defer task
+
+	for(i = 0; i < DEFER_NUM; i ++) {
+
+		g_defer[i].func = NULL;
+	}
+
+	g_defer_head = 0;
+	g_defer_tail = 0;
+	g_defer_wake = 0;
+	create_sem(&defer_sem, 0);
+	create_task(&defer_task, defer_running_func, NULL, defer_stack, 1024);
+	set_task_prio(&defer_task, DEFER_PRIO);
 
 	// about idle task
 
 	g_idle = 0;
 	create_task(&idle_task, idle_running_func, NULL, idle_stack, 1024);
+	set_task_prio(&idle_task, IDLE_PRIO);
 
 }
 
@@ -109,370 +187,4780 @@ void os_start() {
 }
 
 
-// os lock and unlock function
+// os lock and unlock function, g_sched_lock holds one counter per cpu and
+// only the task running on that cpu changes it, so no critical section is
+// needed
 
 void sched_lock() {
 
-	DISABLE_IE();
-	g_sched_lock ++;
-	ENABLE_IE();
-
+	g_sched_lock[CPU_ID()] ++;
 }
 
 void sched_unlock() {
 
-	DISABLE_IE();
-	g_sched_lock --;
-	ENABLE_IE();
+	g_sched_lock[CPU_ID()] --;
 }
 
 static STATUS is_sched_lock() {
 
-	STATUS result;
-
-	DISABLE_IE();
-	result = g_sched_lock > 0;
-	ENABLE_IE();
-
-	return result;
+	return g_sched_lock[CPU_ID()] > 0;
 }
 
 
-// about rdy queue
+// about rdy queue, one fifo per priority and a bitmap of non-empty ones
 
-static void add_to_rdy_queue(Task* p_task) {
+static u32 find_first_bit(u32 val) {
 
-	list_insert(&g_run_queue, &p_task-> rdy);
-}
+	u32 bit = 0;
 
-static void remove_from_rdy_queue(Task* p_task) {
+	if(!(val & 0xffff)) {
 
-	list_delete(&p_task-> rdy);
-}
+		val >>= 16;
+		bit += 16;
+	}
 
-static Task* get_rdy_task(){
+	if(!(val & 0xff)) {
 
-	return get_list_entry(g_run_queue.next, Task, rdy);
-}
+		val >>= 8;
+		bit += 8;
+	}
 
-// about blk queue
+	if(!(val & 0xf)) {
 
-static void add_to_blk_queue(ListNode* head, Task* p_task){
+		val >>= 4;
+		bit += 4;
+	}
 
-	list_insert(head, &p_task-> blk);
-}
+	if(!(val & 0x3)) {
 
+		val >>= 2;
+		bit += 2;
+	}
 
-static void remove_from_blk_queue(Task* p_task) {
+	if(!(val & 0x1)) {
 
-	list_delete(&p_task-> blk);
+		bit += 1;
+	}
+
+	return bit;
 }
 
+// edf tasks sit in a binary min-heap on abs_deadline, each task keeps its
+// heap slot in edf_index
 
-// dispatch function
+static void edf_heap_set(u32 index, Task* p_task) {
 
-static STATUS dispatch() {
+	g_edf_heap[index] = p_task;
+	p_task-> edf_index = index;
+}
 
-	if(is_in_irq()) {
+static void edf_heap_up(u32 index) {
 
-		return IN_IRQ;
-	}
+	Task* p_task;
+	u32 parent;
 
-	if(is_sched_lock()) {
+	p_task = g_edf_heap[index];
 
-		return OS_SCHED_LOCKED;
-	}
+	while(index) {
 
-	sched_task = get_rdy_task();
-	if(sched_task != current_task) {
+		parent = (index - 1) >> 1;
+		if(g_edf_heap[parent]-> abs_deadline <= p_task-> abs_deadline) {
 
-		sched_task-> state = RUNNING;
+			break;
+		}
 
-		CONTEXT_SWITCH();
+		edf_heap_set(index, g_edf_heap[parent]);
+		index = parent;
 	}
 
-	return SUCCESS;
-
+	edf_heap_set(index, p_task);
 }
 
-// yield function 
+static void edf_heap_down(u32 index) {
 
-void yield() {
+	Task* p_task;
+	u32 child;
 
-	if(is_in_irq()) {
+	p_task = g_edf_heap[index];
 
-		return;
-	}
+	while(1) {
 
-	if(is_sched_lock()) {
+		child = (index << 1) + 1;
+		if(child >= g_edf_count) {
 
-		return;
-	}
+			break;
+		}
 
-	DISABLE_IE();
-	
-	remove_from_rdy_queue(current_task);
-	add_to_rdy_queue(current_task);
+		if(child + 1 < g_edf_count && g_edf_heap[child + 1]-> abs_deadline < g_edf_heap[child]-> abs_deadline) {
 
-	sched_task = get_rdy_task();
-	if(sched_task != current_task) {
+			child ++;
+		}
 
-		current_task-> state = READY;
-		sched_task-> state = RUNNING;
+		if(p_task-> abs_deadline <= g_edf_heap[child]-> abs_deadline) {
 
-		CONTEXT_SWITCH();
+			break;
+		}
+
+		edf_heap_set(index, g_edf_heap[child]);
+		index = child;
 	}
 
-	ENABLE_IE();
+	edf_heap_set(index, p_task);
 }
 
+// run queue slot of a task, a throttled task in a demoting budget sits at
+// the budget priority unless its own is already lower
 
-// create task
- 
-STATUS create_task(Task* p_task, void* entry, void* param, void* p_stack, u32 stack_size) {
+static u8 rdy_prio(Task* p_task) {
 
-	if(NULL == p_task) {
+	Budget* p_budget;
 
-		return PARAM_ERROR;
-	}
+	p_budget = p_task-> budget;
 
-	if(NULL == entry) {
+	if(NULL != p_budget && p_budget-> throttled && p_budget-> prio > p_task-> prio) {
 
-		return PARAM_ERROR;
+		return p_budget-> prio;
 	}
 
-	if(NULL == p_stack) {
+	return p_task-> prio;
+}
 
-		return PARAM_ERROR;
-	}
+static STATUS is_task_parked(Task* p_task) {
 
-	if(0 == stack_size) {
+	Budget* p_budget;
 
-		return PARAM_ERROR;
-	}
+	p_budget = p_task-> budget;
 
-	p_task-> entry = entry;
-	p_task-> param = param;
-	p_task-> stack_size = stack_size;
+	return NULL != p_budget && p_budget-> throttled && BUDGET_SUSPEND == p_budget-> action;
+}
 
-	p_task-> msg = NULL;
+static void add_to_rdy_queue(Task* p_task) {
 
-	p_task-> buf_msg = NULL;
+	u8 prio;
 
-	p_task-> event_opt = 0;
-	p_task-> event_val = 0;
-	p_task-> event_data = 0;
+	if(p_task-> edf) {
 
-	list_init(&p_task-> blk);
-	list_init(&p_task-> rdy);
+		edf_heap_set(g_edf_count, p_task);
+		g_edf_count ++;
+		edf_heap_up(p_task-> edf_index);
 
-	p_task-> stack_base = (void*) INIT_STACK_DATA(p_task, p_stack, stack_size, entry, param);
+		return;
+	}
 
-	DISABLE_IE();
-	add_to_rdy_queue(p_task);
+	// a suspended group keeps its ready tasks off the run queue
 
-	p_task-> state = READY;
+	if(is_task_parked(p_task)) {
 
-	ENABLE_IE();
+		list_insert(&p_task-> budget-> parked, &p_task-> rdy);
 
-	return SUCCESS;
+		return;
+	}
 
+	prio = rdy_prio(p_task);
+
+	list_insert(&g_run_queue[prio], &p_task-> rdy);
+	g_rdy_bitmap |= 1 << prio;
 }
 
-// shutdown task
+static void remove_from_rdy_queue(Task* p_task) {
 
-STATUS shutdown_task(Task* p_task){
+	u32 index;
+	u8 prio;
 
-	if(NULL == p_task){
+	if(p_task-> edf) {
 
-		return PARAM_ERROR;
-	}
+		index = p_task-> edf_index;
+		g_edf_count --;
 
-	DISABLE_IE();
+		// refill the hole with the last task, which then moves up or down
 
-	if(current_task == p_task){
+		if(index != g_edf_count) {
 
-		ENABLE_IE();
+			p_task = g_edf_heap[g_edf_count];
 
-		return SELF_KILL_FORBID;
-	}
+			edf_heap_set(index, p_task);
+			edf_heap_up(index);
+			edf_heap_down(p_task-> edf_index);
+		}
 
-	if (READY == p_task-> state) {
+		return;
+	}
 
-		list_delete(&p_task-> rdy);
+	list_delete(&p_task-> rdy);
 
-	}else if(BLOCKED == p_task-> state){
+	if(is_task_parked(p_task)) {
 
-		list_delete(&p_task-> blk);
+		return;
 	}
 
-	p_task-> state = DIE;
-
-	ENABLE_IE();
+	prio = rdy_prio(p_task);
 
-	return SUCCESS;
+	if(is_list_empty(&g_run_queue[prio])) {
 
+		g_rdy_bitmap &= ~(1 << prio);
+	}
 }
 
-// resume task
+// p_old leaves the run queue and p_new takes its place. in the same class
+// and slot p_new just takes over the node, so neither the bitmap nor the
+// edf heap is touched. caller holds the run queue lock
 
-STATUS resume_task(Task* p_task){
+static void replace_in_rdy_queue(Task* p_old, Task* p_new) {
 
-	if(NULL == p_task) {
+	if(!p_old-> edf && !p_new-> edf && !is_task_parked(p_old) && !is_task_parked(p_new)
+		&& rdy_prio(p_old) == rdy_prio(p_new)) {
 
-		return PARAM_ERROR;
+		p_new-> rdy.next = p_old-> rdy.next;
+		p_new-> rdy.prev = p_old-> rdy.prev;
+		p_new-> rdy.next-> prev = &p_new-> rdy;
+		p_new-> rdy.prev-> next = &p_new-> rdy;
+
+		return;
 	}
 
-	DISABLE_IE();
+	remove_from_rdy_queue(p_old);
+	add_to_rdy_queue(p_new);
+}
 
-	if(READY == p_task-> state || BLOCKED == p_task-> state){
+// edf tasks run ahead of every level from EDF_PRIO on, ordinary tasks get
+// the slack. the idle task never blocks, so the bitmap is never empty
 
-		ENABLE_IE();
+static Task* get_rdy_task(){
 
-		return SUCCESS;
+	u32 prio;
+
+	prio = find_first_bit(g_rdy_bitmap);
+
+	if(g_edf_count && prio >= EDF_PRIO) {
+
+		return g_edf_heap[0];
 	}
 
-	p_task-> state = READY;
-	add_to_rdy_queue(p_task);
+	return get_list_entry(g_run_queue[prio].next, Task, rdy);
+}
 
-	ENABLE_IE();
+// about blk queue, caller holds the object lock
 
-	return SUCCESS;
+static void add_to_blk_queue(ListNode* head, u32* p_lock, Task* p_task){
+
+	list_insert(head, &p_task-> blk);
+	p_task-> blk_lock = p_lock;
 }
 
-// create semaphore
 
-STATUS create_sem(Sem* p_sem, u32 count) {
+static void remove_from_blk_queue(Task* p_task) {
 
-	if(NULL == p_sem) {
+	list_delete(&p_task-> blk);
+	list_init(&p_task-> blk);
+	p_task-> blk_lock = NULL;
+}
 
-		return PARAM_ERROR;
-	}
+// move a blocked task back to the run queue, caller holds the object lock
 
-	p_sem-> blk_type = SEM_TYPE;
-	list_init(&p_sem-> head);
-	p_sem-> count = count;
+static void wake_blk_task(Task* p_task) {
 
-	return SUCCESS;
+	remove_from_blk_queue(p_task);
+
+	p_task-> wake_ns = GET_NS();
 
+	RDY_LOCK();
+	add_to_rdy_queue(p_task);
+	p_task-> state = READY;
+	RDY_UNLOCK();
 }
 
-// get semaphore
 
-STATUS get_sem(Sem* p_sem, u8 wait) {
+// about select, an object keeps the items of the tasks selecting on it in
+// its sel list. every object select works on starts with this layout
 
-	STATUS result;
+typedef struct _SelObj {
 
-	if(is_in_irq()) {
+	u32 blk_type;
+	u32 lock;
+	ListNode head;
+	ListNode sel;
+}SelObj;
 
-		return IN_IRQ;
-	}
+// whether a select item could be taken right now, caller holds the object lock
 
-	if(NULL == p_sem) {
+static STATUS is_item_ready(SelectItem* p_item) {
 
-		return PARAM_ERROR;
-	}
+	u32 type;
 
-	if(SEM_TYPE != p_sem-> blk_type) {
+	type = ((SelObj*) p_item-> obj)-> blk_type;
 
-		return WRONG_BLOCK_TYPE;
-	}
+	if(SEM_TYPE == type) {
 
-	DISABLE_IE();
-	if(p_sem-> count) {
+		return (((Sem*) p_item-> obj)-> count & ~HAS_WAITER) != 0 && is_list_empty(&((Sem*) p_item-> obj)-> head);
 
-		p_sem-> count -= 1;
-		ENABLE_IE();
+	}else if(MAIL_TYPE == type) {
 
-		return SUCCESS;
-	}
+		return ((Mailbox*) p_item-> obj)-> msg != NULL;
 
-	if(is_sched_lock()) {
+	}else if(BUF_TYPE == type) {
 
-		ENABLE_IE();
+		return ((Msgbuf*) p_item-> obj)-> count != 0;
 
-		return OS_SCHED_LOCKED;
-	}	
+	}else if(PRIO_BUF_TYPE == type) {
 
-	if(!wait) {
+		return ((PrioMsgbuf*) p_item-> obj)-> count != 0;
 
-		ENABLE_IE();
+	}else if(EVENT_TYPE == type) {
 
-		return NOT_WAIT;
+		return (((Event*) p_item-> obj)-> val & p_item-> event_val) != 0;
 	}
-	
-	remove_from_rdy_queue(current_task);
-	add_to_blk_queue(&p_sem-> head, current_task);
-
-	current_task-> state = BLOCKED;
-	
-	result = dispatch();
 
-	ENABLE_IE();
-
-	return result;
+	return 0;
 }
 
-// put semaphore
+// wake the tasks selecting on an object that just became ready, caller
+// holds the object lock. only the items of this object are walked
 
-STATUS put_sem(Sem* p_sem) {
+static void wake_sel_task(ListNode* sel) {
 
+	ListNode* p_node;
+	SelectItem* p_item;
 	Task* p_task;
 
-	if(NULL == p_sem) {
+	for(p_node = sel-> next; p_node != sel; p_node = p_node-> next) {
 
-		return PARAM_ERROR;
-	}
+		p_item = get_list_entry(p_node, SelectItem, node);
+		if(!is_item_ready(p_item)) {
 
-	if(SEM_TYPE != p_sem-> blk_type) {
+			continue;
+		}
 
-		return WRONG_BLOCK_TYPE;
-	}
-	
-	DISABLE_IE();
+		p_task = p_item-> task;
 
-	if(is_list_empty(&p_sem->head)) {
+		RDY_LOCK();
 
-		p_sem->count += 1;
-	
-		ENABLE_IE();
+		if(p_task-> sel_wait) {
 
-		return SUCCESS;
-	}
+			p_task-> sel_wait = 0;
 
-	p_task = get_list_entry(p_sem->head.next, Task, blk);
+			if(BLOCKED == p_task-> state) {
 
-	remove_from_blk_queue(p_task);
-	add_to_rdy_queue(p_task);
+				p_task-> wake_ns = GET_NS();
 
-	p_task-> state = READY;
-	
-	ENABLE_IE();
+				add_to_rdy_queue(p_task);
+				p_task-> state = READY;
+			}
+		}
 
-	return SUCCESS;
+		RDY_UNLOCK();
+	}
 }
 
-// create mutex
+// take the items of a task off their objects, returns the first ready one
+// or num when none is
 
-STATUS create_mutex(Mutex* p_mutex) {
+static u32 remove_sel_item(SelectItem* p_item, u32 num) {
 
-	if(NULL == p_mutex) {
+	u32 index;
+	u32 i;
 
-		return PARAM_ERROR;
-	}
+	index = num;
 
-	p_mutex-> blk_type = MUT_TYPE;
-	list_init(&p_mutex-> head);
-	p_mutex-> count = 1;
-	p_mutex-> owner = NULL;
+	for(i = 0; i < num; i ++) {
+
+		OBJ_LOCK((SelObj*) p_item[i].obj);
+
+		if(!is_list_empty(&p_item[i].node)) {
+
+			list_delete(&p_item[i].node);
+			list_init(&p_item[i].node);
+		}
+
+		if(index == num && is_item_ready(&p_item[i])) {
+
+			index = i;
+		}
+
+		OBJ_UNLOCK((SelObj*) p_item[i].obj);
+	}
+
+	return index;
+}
+
+// dispatch function, caller holds the run queue lock
+
+static STATUS dispatch() {
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(is_sched_lock()) {
+
+		return OS_SCHED_LOCKED;
+	}
+
+	sched_task = get_rdy_task();
+	if(sched_task != current_task) {
+
+		sched_task-> state = RUNNING;
+
+		CONTEXT_SWITCH();
+	}
+
+	return SUCCESS;
+
+}
+
+// hand the cpu straight to a ready task, skipping get_rdy_task(). caller
+// holds the run queue lock
+
+static void switch_to_task(Task* p_task) {
+
+	if(p_task == current_task) {
+
+		return;
+	}
+
+	if(RUNNING == current_task-> state) {
+
+		current_task-> state = READY;
+	}
+
+	sched_task = p_task;
+	sched_task-> state = RUNNING;
+
+	CONTEXT_SWITCH();
+}
+
+// block current task on an object, the object lock is dropped once the
+// run queue lock is held so no waker can miss the task
+
+static STATUS block_cur_task(ListNode* head, u32* p_lock) {
+
+	STATUS result;
+
+	current_task-> blk_ns = GET_NS();
+
+	add_to_blk_queue(head, p_lock, current_task);
+
+	RDY_LOCK();
+	remove_from_rdy_queue(current_task);
+	current_task-> state = BLOCKED;
+	SPIN_UNLOCK(p_lock);
+
+	result = dispatch();
+	RDY_UNLOCK();
+
+	return result;
+}
+
+// yield function 
+
+void yield() {
+
+	if(is_in_irq()) {
+
+		return;
+	}
+
+	if(is_sched_lock()) {
+
+		return;
+	}
+
+	DISABLE_IE();
+	RDY_LOCK();
+	
+	remove_from_rdy_queue(current_task);
+	add_to_rdy_queue(current_task);
+
+	sched_task = get_rdy_task();
+	if(sched_task != current_task) {
+
+		current_task-> state = READY;
+		sched_task-> state = RUNNING;
+
+		CONTEXT_SWITCH();
+	}
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+}
+
+
+// create task
+ 
+STATUS create_task(Task* p_task, void* entry, void* param, void* p_stack, u32 stack_size) {
+
+	if(NULL == p_task) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == entry) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_stack) {
+
+		return PARAM_ERROR;
+	}
+
+	if(0 == stack_size) {
+
+		return PARAM_ERROR;
+	}
+
+	p_task-> entry = entry;
+	p_task-> param = param;
+	p_task-> stack_size = stack_size;
+
+	p_task-> msg = NULL;
+
+	p_task-> buf_msg = NULL;
+	p_task-> queue_item = NULL;
+	p_task-> sem_need = 0;
+	p_task-> cond_signaled = 0;
+	p_task-> cond_wait = NULL;
+
+	p_task-> event_opt = 0;
+	p_task-> event_val = 0;
+	p_task-> event_data = 0;
+
+	list_init(&p_task-> blk);
+	list_init(&p_task-> rdy);
+	p_task-> blk_lock = NULL;
+	p_task-> prio = DEFAULT_PRIO;
+	p_task-> base_prio = DEFAULT_PRIO;
+	list_init(&p_task-> ceiling_held);
+
+	p_task-> blk_ns = 0;
+	p_task-> wake_ns = 0;
+
+	p_task-> period = 0;
+	p_task-> deadline_miss = 0;
+	p_task-> jitter_max = 0;
+	p_task-> response_max = 0;
+
+	p_task-> edf = 0;
+
+	p_task-> budget = NULL;
+	list_init(&p_task-> budget_node);
+
+	p_task-> notify_val = 0;
+	p_task-> notify_pending = 0;
+	p_task-> notify_wait = 0;
+
+	create_timer(&p_task-> wait_timer, 1, wait_timeout_func, p_task);
+	p_task-> wait_timer.hard = 1;
+	p_task-> wait_timeout = 0;
+
+	p_task-> ipc_msg = NULL;
+	p_task-> ipc_reply = NULL;
+	p_task-> ipc_wait = 0;
+	p_task-> ipc_client = NULL;
+	p_task-> ipc_server = NULL;
+	p_task-> ipc_chan = NULL;
+	p_task-> ipc_lent = PRIO_NUM;
+
+	p_task-> sel_wait = 0;
+	p_task-> sel_item = NULL;
+	p_task-> sel_num = 0;
+
+	p_task-> stack_base = (void*) INIT_STACK_DATA(p_task, p_stack, stack_size, entry, param);
+
+	DISABLE_IE();
+	RDY_LOCK();
+	add_to_rdy_queue(p_task);
+
+	p_task-> state = READY;
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+
+	return SUCCESS;
+
+}
+
+// move a task to another priority, caller holds the run queue lock
+
+static void change_task_prio(Task* p_task, u8 prio) {
+
+	if(READY == p_task-> state || RUNNING == p_task-> state) {
+
+		remove_from_rdy_queue(p_task);
+		p_task-> prio = prio;
+		add_to_rdy_queue(p_task);
+
+	}else {
+
+		p_task-> prio = prio;
+	}
+}
+
+// the prio a task runs at, its own one raised by the ceilings of the
+// mutexes it holds, the client it serves and the clients queued for it.
+// caller holds the run queue lock and the lock of the channel it serves
+
+static u8 boost_prio(Task* p_task) {
+
+	ListNode* p_node;
+	Mutex* p_mutex;
+	Task* p_client;
+	u8 prio;
+
+	prio = p_task-> base_prio;
+
+	for(p_node = p_task-> ceiling_held.next; p_node != &p_task-> ceiling_held; p_node = p_node-> next) {
+
+		p_mutex = get_list_entry(p_node, Mutex, held);
+		if(p_mutex-> ceiling < prio) {
+
+			prio = p_mutex-> ceiling;
+		}
+	}
+
+	if(p_task-> ipc_lent < prio) {
+
+		prio = p_task-> ipc_lent;
+	}
+
+	if(NULL != p_task-> ipc_chan && p_task == p_task-> ipc_chan-> server) {
+
+		for(p_node = p_task-> ipc_chan-> head.next; p_node != &p_task-> ipc_chan-> head; p_node = p_node-> next) {
+
+			p_client = get_list_entry(p_node, Task, blk);
+			if(p_client-> prio < prio) {
+
+				prio = p_client-> prio;
+			}
+		}
+	}
+
+	return prio;
+}
+
+// set task priority, 0 is the highest
+
+STATUS set_task_prio(Task* p_task, u8 prio) {
+
+	if(NULL == p_task) {
+
+		return PARAM_ERROR;
+	}
+
+	if(prio >= PRIO_NUM) {
+
+		return PARAM_ERROR;
+	}
+
+	DISABLE_IE();
+	RDY_LOCK();
+
+	p_task-> base_prio = prio;
+	change_task_prio(p_task, prio);
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// release timer of a periodic task, runs in the tick isr
+
+static void release_task_func(void* param) {
+
+	Task* p_task;
+
+	p_task = (Task*) param;
+
+	RDY_LOCK();
+
+	if(BLOCKED == p_task-> state && p_task-> period) {
+
+		p_task-> abs_deadline = p_task-> release + p_task-> deadline;
+		p_task-> release_ns = GET_NS();
+		p_task-> wake_ns = p_task-> release_ns;
+
+		add_to_rdy_queue(p_task);
+		p_task-> state = READY;
+	}
+
+	RDY_UNLOCK();
+}
+
+// start releasing a task every period ticks from now on, each job should
+// finish within deadline ticks of its release. caller holds the run queue
+// lock
+
+static void start_period(Task* p_task, u32 period, u32 deadline) {
+
+	p_task-> period = period;
+	p_task-> deadline = deadline;
+	p_task-> release = g_tick;
+	p_task-> abs_deadline = g_tick + deadline;
+	p_task-> release_ns = GET_NS();
+
+	create_timer(&p_task-> release_timer, 1, release_task_func, p_task);
+	p_task-> release_timer.hard = 1;
+}
+
+// make a task periodic, it is released every period ticks and each job must
+// finish within deadline ticks of its release, 0 means the period
+
+STATUS set_task_period(Task* p_task, u32 period, u32 deadline) {
+
+	if(NULL == p_task) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!period || p_task-> period) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!deadline) {
+
+		deadline = period;
+	}
+
+	DISABLE_IE();
+	RDY_LOCK();
+
+	start_period(p_task, period, deadline);
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// create periodic task, its first job is released right away
+
+STATUS create_periodic_task(Task* p_task, void* entry, void* param, void* p_stack, u32 stack_size, u32 period, u32 deadline) {
+
+	STATUS result;
+
+	if(!period) {
+
+		return PARAM_ERROR;
+	}
+
+	result = create_task(p_task, entry, param, p_stack, stack_size);
+	if(SUCCESS != result) {
+
+		return result;
+	}
+
+	return set_task_period(p_task, period, deadline);
+}
+
+// utilization of an edf task, runtime over the tighter of period and
+// deadline so constrained deadlines are admitted conservatively
+
+static u32 edf_util(u32 runtime, u32 period, u32 deadline) {
+
+	if(deadline < period) {
+
+		period = deadline;
+	}
+
+	return (u32) (((u64) runtime * EDF_UTIL_MAX + period - 1) / period);
+}
+
+// move a task into the edf class, it needs runtime ticks of cpu every
+// period ticks and must finish each job within deadline ticks of release.
+// the task set is rejected when the total utilization would exceed 100%
+
+STATUS set_task_edf(Task* p_task, u32 runtime, u32 period, u32 deadline) {
+
+	u32 util;
+
+	if(NULL == p_task) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!runtime || !period || !deadline || runtime > deadline) {
+
+		return PARAM_ERROR;
+	}
+
+	if(p_task-> edf || p_task-> period || NULL != p_task-> budget) {
+
+		return PARAM_ERROR;
+	}
+
+	util = edf_util(runtime, period, deadline);
+
+	DISABLE_IE();
+	RDY_LOCK();
+
+	if(g_edf_util + util > EDF_UTIL_MAX || g_edf_count == EDF_TASK_NUM) {
+
+		RDY_UNLOCK();
+		ENABLE_IE();
+
+		return OVER_UTIL;
+	}
+
+	g_edf_util += util;
+
+	p_task-> edf_runtime = runtime;
+	start_period(p_task, period, deadline);
+
+	if(READY == p_task-> state || RUNNING == p_task-> state) {
+
+		remove_from_rdy_queue(p_task);
+		p_task-> edf = 1;
+		add_to_rdy_queue(p_task);
+
+	}else {
+
+		p_task-> edf = 1;
+	}
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// end the current job of a periodic task and sleep until the next release.
+// releases stay on the g_tick grid, so lateness never accumulates. a job
+// that finished after its absolute deadline counts as a deadline miss
+
+STATUS wait_next_period() {
+
+	STATUS result;
+	u64 now_ns;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(!current_task-> period) {
+
+		return PARAM_ERROR;
+	}
+
+	if(is_sched_lock()) {
+
+		return OS_SCHED_LOCKED;
+	}
+
+	DISABLE_IE();
+
+	now_ns = GET_NS();
+	if(now_ns - current_task-> release_ns > current_task-> response_max) {
+
+		current_task-> response_max = now_ns - current_task-> release_ns;
+	}
+
+	if(g_tick > current_task-> abs_deadline) {
+
+		current_task-> deadline_miss ++;
+	}
+
+	current_task-> release += current_task-> period;
+
+	// already released again, the next job starts right away
+
+	if(current_task-> release <= g_tick) {
+
+		current_task-> release_ns += (u64) current_task-> period * TICK_NS();
+
+		RDY_LOCK();
+		remove_from_rdy_queue(current_task);
+		current_task-> abs_deadline = current_task-> release + current_task-> deadline;
+		add_to_rdy_queue(current_task);
+
+		result = SUCCESS;
+
+		sched_task = get_rdy_task();
+		if(sched_task != current_task) {
+
+			current_task-> state = READY;
+			sched_task-> state = RUNNING;
+
+			CONTEXT_SWITCH();
+		}
+
+		RDY_UNLOCK();
+
+	}else {
+
+		current_task-> release_timer.val = (u32) (current_task-> release - g_tick);
+		activate_timer(&current_task-> release_timer);
+
+		// blocked on no object, the release timer wakes us
+
+		list_init(&current_task-> blk);
+		current_task-> blk_lock = NULL;
+		current_task-> blk_ns = now_ns;
+
+		RDY_LOCK();
+		remove_from_rdy_queue(current_task);
+		current_task-> state = BLOCKED;
+
+		result = dispatch();
+		RDY_UNLOCK();
+	}
+
+	// release jitter, how late the new job got the cpu
+
+	now_ns = GET_NS();
+	if(now_ns - current_task-> release_ns > current_task-> jitter_max) {
+
+		current_task-> jitter_max = now_ns - current_task-> release_ns;
+	}
+
+	ENABLE_IE();
+
+	return result;
+}
+
+// flip the throttle state of a budget, the ready tasks of the group leave
+// the run queue first and come back at their new slot. caller holds the
+// run queue lock
+
+static void set_budget_throttle(Budget* p_budget, u8 throttled) {
+
+	ListNode* p_node;
+	Task* p_task;
+
+	for(p_node = p_budget-> task.next; p_node != &p_budget-> task; p_node = p_node-> next) {
+
+		p_task = get_list_entry(p_node, Task, budget_node);
+		if(READY == p_task-> state || RUNNING == p_task-> state) {
+
+			remove_from_rdy_queue(p_task);
+		}
+	}
+
+	p_budget-> throttled = throttled;
+
+	for(p_node = p_budget-> task.next; p_node != &p_budget-> task; p_node = p_node-> next) {
+
+		p_task = get_list_entry(p_node, Task, budget_node);
+		if(READY == p_task-> state || RUNNING == p_task-> state) {
+
+			add_to_rdy_queue(p_task);
+		}
+	}
+}
+
+// refill timer of a budget, runs in the tick isr
+
+static void budget_refill_func(void* param) {
+
+	Budget* p_budget;
+
+	p_budget = (Budget*) param;
+
+	RDY_LOCK();
+
+	p_budget-> left = p_budget-> budget;
+
+	if(p_budget-> throttled) {
+
+		p_budget-> throttle_ticks += g_tick - p_budget-> throttle_start;
+		set_budget_throttle(p_budget, 0);
+	}
+
+	RDY_UNLOCK();
+}
+
+// charge the tick to the budget of the task it interrupted, called from
+// the tick isr. the throttle takes effect at the task's next yield or block
+
+static void charge_budget() {
+
+	Budget* p_budget;
+
+	if(NULL == current_task) {
+
+		return;
+	}
+
+	RDY_LOCK();
+
+	p_budget = current_task-> budget;
+
+	if(NULL != p_budget && RUNNING == current_task-> state) {
+
+		p_budget-> used ++;
+
+		if(p_budget-> left && !(-- p_budget-> left)) {
+
+			p_budget-> throttle_count ++;
+			p_budget-> throttle_start = g_tick;
+			set_budget_throttle(p_budget, 1);
+		}
+	}
+
+	RDY_UNLOCK();
+}
+
+// create a cpu budget, its tasks together may run budget ticks in every
+// period ticks. once it runs out they are demoted to prio or suspended,
+// as action says, until the budget is refilled at the next period
+
+STATUS create_budget(Budget* p_budget, u32 budget, u32 period, u8 action, u8 prio) {
+
+	if(NULL == p_budget) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!budget || budget > period) {
+
+		return PARAM_ERROR;
+	}
+
+	if(BUDGET_DEMOTE != action && BUDGET_SUSPEND != action) {
+
+		return PARAM_ERROR;
+	}
+
+	if(prio >= PRIO_NUM) {
+
+		return PARAM_ERROR;
+	}
+
+	p_budget-> budget = budget;
+	p_budget-> period = period;
+	p_budget-> left = budget;
+	p_budget-> action = action;
+	p_budget-> prio = prio;
+	p_budget-> throttled = 0;
+	list_init(&p_budget-> task);
+	list_init(&p_budget-> parked);
+
+	p_budget-> used = 0;
+	p_budget-> throttle_count = 0;
+	p_budget-> throttle_ticks = 0;
+	p_budget-> throttle_start = 0;
+
+	create_periodic_timer(&p_budget-> timer, period, period, budget_refill_func, p_budget);
+	set_timer_hard(&p_budget-> timer, 1);
+
+	return activate_timer(&p_budget-> timer);
+}
+
+// charge a task to a budget, NULL takes it out of its budget again. edf
+// tasks are bounded by their own runtime and can not join a budget
+
+STATUS set_task_budget(Task* p_task, Budget* p_budget) {
+
+	u8 ready;
+
+	if(NULL == p_task) {
+
+		return PARAM_ERROR;
+	}
+
+	if(p_task-> edf) {
+
+		return PARAM_ERROR;
+	}
+
+	DISABLE_IE();
+	RDY_LOCK();
+
+	ready = READY == p_task-> state || RUNNING == p_task-> state;
+	if(ready) {
+
+		remove_from_rdy_queue(p_task);
+	}
+
+	if(NULL != p_task-> budget) {
+
+		list_delete(&p_task-> budget_node);
+	}
+
+	p_task-> budget = p_budget;
+
+	if(NULL != p_budget) {
+
+		list_insert(&p_budget-> task, &p_task-> budget_node);
+	}
+
+	if(ready) {
+
+		add_to_rdy_queue(p_task);
+	}
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// shutdown task
+
+STATUS shutdown_task(Task* p_task){
+
+	SelObj* p_obj;
+	Channel* p_chan;
+	Task* p_server;
+	Mutex* p_mutex;
+	u32* p_lock;
+
+	if(NULL == p_task){
+
+		return PARAM_ERROR;
+	}
+
+	DISABLE_IE();
+
+	if(current_task == p_task){
+
+		ENABLE_IE();
+
+		return SELF_KILL_FORBID;
+	}
+
+	if(p_task-> period) {
+
+		deactivate_timer(&p_task-> release_timer);
+	}
+
+	deactivate_timer(&p_task-> wait_timer);
+
+	if(NULL != p_task-> sel_item) {
+
+		remove_sel_item(p_task-> sel_item, p_task-> sel_num);
+		p_task-> sel_item = NULL;
+	}
+
+	// a client being served lent its prio to the server, take it back. the
+	// reply clears ipc_server under the same locks, so the loop ends either way
+
+	while(NULL != (p_server = p_task-> ipc_server)) {
+
+		p_chan = p_server-> ipc_chan;
+
+		OBJ_LOCK(p_chan);
+		RDY_LOCK();
+
+		if(p_server == p_task-> ipc_server) {
+
+			p_task-> ipc_server = NULL;
+			p_task-> ipc_wait = 0;
+
+			p_server-> ipc_client = NULL;
+			p_server-> ipc_lent = PRIO_NUM;
+			change_task_prio(p_server, boost_prio(p_server));
+		}
+
+		RDY_UNLOCK();
+		OBJ_UNLOCK(p_chan);
+	}
+
+	// the object lock comes first, so pin the blk list before the run queue.
+	// the task may move to another list meanwhile, then try again
+
+	while(1) {
+
+		p_lock = p_task-> blk_lock;
+		if(NULL != p_lock) {
+
+			SPIN_LOCK(p_lock);
+		}
+
+		RDY_LOCK();
+
+		if(p_lock == p_task-> blk_lock) {
+
+			break;
+		}
+
+		RDY_UNLOCK();
+		if(NULL != p_lock) {
+
+			SPIN_UNLOCK(p_lock);
+		}
+	}
+
+	p_obj = NULL;
+
+	if (READY == p_task-> state) {
+
+		remove_from_rdy_queue(p_task);
+
+	}else if(BLOCKED == p_task-> state && NULL != p_lock){
+
+		remove_from_blk_queue(p_task);
+
+		// every object starts with blk_type and the lock
+
+		p_obj = get_list_entry(p_lock, SelObj, lock);
+
+		// a client queued on a channel lends its prio to the server
+
+		if(CHAN_TYPE == p_obj-> blk_type) {
+
+			p_server = ((Channel*) p_obj)-> server;
+			if(NULL != p_server && p_task != p_server) {
+
+				change_task_prio(p_server, boost_prio(p_server));
+			}
+		}
+	}
+
+	if(NULL != p_task-> budget) {
+
+		list_delete(&p_task-> budget_node);
+		p_task-> budget = NULL;
+	}
+
+	// a dead edf task gives its bandwidth back
+
+	if(p_task-> edf) {
+
+		g_edf_util -= edf_util(p_task-> edf_runtime, p_task-> period, p_task-> deadline);
+		p_task-> edf = 0;
+	}
+
+	p_task-> period = 0;
+
+	p_task-> state = DIE;
+
+	RDY_UNLOCK();
+
+	// a big get_sem_n() request holds back the smaller ones behind it, so
+	// once it is gone the units may serve them
+
+	if(NULL != p_obj && SEM_TYPE == p_obj-> blk_type) {
+
+		serve_sem((Sem*) p_obj, ((Sem*) p_obj)-> count & ~HAS_WAITER);
+	}
+
+	if(NULL != p_lock) {
+
+		SPIN_UNLOCK(p_lock);
+	}
+
+	// a signal may have handed the cond mutex to the task before it got to
+	// run again, then it would stay locked for good. pass it on instead
+
+	if(NULL != p_task-> cond_wait) {
+
+		p_mutex = p_task-> cond_wait-> p_mutex;
+		p_task-> cond_wait = NULL;
+
+		OBJ_LOCK(p_mutex);
+
+		if(p_task == p_mutex-> owner) {
+
+			p_mutex-> owner = NULL;
+			hand_over_mutex(p_mutex);
+		}
+
+		OBJ_UNLOCK(p_mutex);
+	}
+
+	// drop the ceiling prio, and pass on every ceiling mutex the task still
+	// holds so its waiters do not sleep on a dead owner
+
+	while(1) {
+
+		RDY_LOCK();
+
+		if(is_list_empty(&p_task-> ceiling_held)) {
+
+			change_task_prio(p_task, p_task-> base_prio);
+			RDY_UNLOCK();
+
+			break;
+		}
+
+		p_mutex = get_list_entry(p_task-> ceiling_held.next, Mutex, held);
+		list_delete(&p_mutex-> held);
+		list_init(&p_mutex-> held);
+
+		RDY_UNLOCK();
+
+		OBJ_LOCK(p_mutex);
+
+		if(p_task == p_mutex-> owner) {
+
+			p_mutex-> owner = NULL;
+			p_mutex-> nest = 0;
+			hand_over_mutex(p_mutex);
+		}
+
+		OBJ_UNLOCK(p_mutex);
+	}
+
+	ENABLE_IE();
+
+	return SUCCESS;
+
+}
+
+// resume task
+
+STATUS resume_task(Task* p_task){
+
+	if(NULL == p_task) {
+
+		return PARAM_ERROR;
+	}
+
+	DISABLE_IE();
+	RDY_LOCK();
+
+	if(READY == p_task-> state || BLOCKED == p_task-> state){
+
+		RDY_UNLOCK();
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	p_task-> state = READY;
+	add_to_rdy_queue(p_task);
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// timeout of a timed wait, runs in the tick isr. the task leaves whatever
+// it sleeps on and finds wait_timeout set, the waiter arms the timer before
+// taking any object lock so the lock order holds
+
+static void wait_timeout_func(void* param) {
+
+	Task* p_task;
+	u32* p_lock;
+
+	p_task = (Task*) param;
+
+	p_lock = p_task-> blk_lock;
+	if(NULL != p_lock) {
+
+		SPIN_LOCK(p_lock);
+	}
+
+	RDY_LOCK();
+
+	p_task-> wait_timeout = 1;
+
+	if(BLOCKED == p_task-> state && p_lock == p_task-> blk_lock) {
+
+		remove_from_blk_queue(p_task);
+
+		p_task-> notify_wait = 0;
+		p_task-> sel_wait = 0;
+		p_task-> wake_ns = GET_NS();
+
+		add_to_rdy_queue(p_task);
+		p_task-> state = READY;
+	}
+
+	RDY_UNLOCK();
+	if(NULL != p_lock) {
+
+		SPIN_UNLOCK(p_lock);
+	}
+}
+
+// notify a task directly, no kernel object is involved. action says how
+// val changes its notify value, a task sleeping in wait_notify() wakes up.
+// like put_* it may be called from isr
+
+STATUS notify_task(Task* p_task, u32 val, u8 action) {
+
+	if(NULL == p_task) {
+
+		return PARAM_ERROR;
+	}
+
+	DISABLE_IE();
+	RDY_LOCK();
+
+	if(NOTIFY_SET_BITS == action) {
+
+		p_task-> notify_val |= val;
+
+	}else if(NOTIFY_INC == action) {
+
+		p_task-> notify_val ++;
+
+	}else if(NOTIFY_OVERWRITE == action) {
+
+		p_task-> notify_val = val;
+
+	}else {
+
+		RDY_UNLOCK();
+		ENABLE_IE();
+
+		return PARAM_ERROR;
+	}
+
+	p_task-> notify_pending = 1;
+
+	if(p_task-> notify_wait) {
+
+		p_task-> notify_wait = 0;
+		p_task-> wake_ns = GET_NS();
+
+		add_to_rdy_queue(p_task);
+		p_task-> state = READY;
+	}
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// wait for a notification up to timeout ticks, NO_WAIT only polls and
+// WAIT_FOREVER never times out. the notify value is returned and cleared
+
+STATUS wait_notify(u32* p_val, u32 timeout) {
+
+	STATUS result;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_val) {
+
+		return PARAM_ERROR;
+	}
+
+	DISABLE_IE();
+
+	result = SUCCESS;
+
+	if(!current_task-> notify_pending) {
+
+		if(NO_WAIT == timeout) {
+
+			ENABLE_IE();
+
+			return NOT_WAIT;
+		}
+
+		if(is_sched_lock()) {
+
+			ENABLE_IE();
+
+			return OS_SCHED_LOCKED;
+		}
+
+		current_task-> wait_timeout = 0;
+
+		if(WAIT_FOREVER != timeout) {
+
+			current_task-> wait_timer.val = timeout;
+			activate_timer(&current_task-> wait_timer);
+		}
+
+		RDY_LOCK();
+
+		// blocked on no object, notify_task() or the timeout wakes us
+
+		if(!current_task-> notify_pending && !current_task-> wait_timeout) {
+
+			list_init(&current_task-> blk);
+			current_task-> blk_lock = NULL;
+			current_task-> blk_ns = GET_NS();
+			current_task-> notify_wait = 1;
+
+			remove_from_rdy_queue(current_task);
+			current_task-> state = BLOCKED;
+
+			result = dispatch();
+		}
+
+		RDY_UNLOCK();
+
+		if(WAIT_FOREVER != timeout) {
+
+			deactivate_timer(&current_task-> wait_timer);
+		}
+	}
+
+	RDY_LOCK();
+
+	if(current_task-> notify_pending) {
+
+		*p_val = current_task-> notify_val;
+		current_task-> notify_val = 0;
+		current_task-> notify_pending = 0;
+
+	}else if(SUCCESS == result) {
+
+		result = TIMEOUT;
+	}
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+
+	return result;
+}
+
+// create semaphore
+
+STATUS create_sem(Sem* p_sem, u32 count) {
+
+	if(NULL == p_sem) {
+
+		return PARAM_ERROR;
+	}
+
+	p_sem-> blk_type = SEM_TYPE;
+	p_sem-> lock = 0;
+	list_init(&p_sem-> head);
+	list_init(&p_sem-> sel);
+	p_sem-> count = count;
+	p_sem-> max = 0;
+
+	return SUCCESS;
+
+}
+
+// limit the count of a semaphore, 0 takes the limit away
+
+STATUS set_sem_max(Sem* p_sem, u32 max) {
+
+	if(NULL == p_sem) {
+
+		return PARAM_ERROR;
+	}
+
+	if(SEM_TYPE != p_sem-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if(max && (p_sem-> count & ~HAS_WAITER) > max) {
+
+		return PARAM_ERROR;
+	}
+
+	p_sem-> max = max;
+
+	return SUCCESS;
+}
+
+// get n units of a semaphore at once. waiters are served in order, so a
+// small request never passes a bigger one that waits already
+
+STATUS get_sem_n(Sem* p_sem, u32 n, u8 wait) {
+
+	STATUS result;
+	u32 count;
+	u32 prev;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_sem) {
+
+		return PARAM_ERROR;
+	}
+
+	if(SEM_TYPE != p_sem-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if(!n || (p_sem-> max && n > p_sem-> max)) {
+
+		return PARAM_ERROR;
+	}
+
+	// fast path, take the units without entering the critical section
+
+	count = p_sem-> count;
+
+	while(!(count & HAS_WAITER) && count >= n) {
+
+		prev = ATOMIC_CAS(&p_sem-> count, count, count - n);
+		if(prev == count) {
+
+			return SUCCESS;
+		}
+
+		count = prev;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_sem);
+
+	while(1) {
+
+		count = p_sem-> count;
+
+		if((count & ~HAS_WAITER) >= n && is_list_empty(&p_sem-> head)) {
+
+			if(ATOMIC_CAS(&p_sem-> count, count, count - n) == count) {
+
+				OBJ_UNLOCK(p_sem);
+				ENABLE_IE();
+
+				return SUCCESS;
+			}
+
+			continue;
+		}
+
+		if(is_sched_lock()) {
+
+			OBJ_UNLOCK(p_sem);
+			ENABLE_IE();
+
+			return OS_SCHED_LOCKED;
+		}	
+
+		if(!wait) {
+
+			OBJ_UNLOCK(p_sem);
+			ENABLE_IE();
+
+			return NOT_WAIT;
+		}
+
+		// once the flag is set every put_sem takes the slow path
+
+		if(ATOMIC_CAS(&p_sem-> count, count, count | HAS_WAITER) == count) {
+
+			break;
+		}
+	}
+
+	// put_sem_n takes our units off the count before waking us
+
+	current_task-> sem_need = n;
+	
+	result = block_cur_task(&p_sem-> head, &p_sem-> lock);
+
+	ENABLE_IE();
+
+	if(SUCCESS == result && !current_task-> sem_need) {
+
+		result = SEM_FLUSHED;
+	}
+
+	return result;
+}
+
+// get semaphore
+
+STATUS get_sem(Sem* p_sem, u8 wait) {
+
+	return get_sem_n(p_sem, 1, wait);
+}
+
+// hand count units to the waiters in order for as long as the first one can
+// be served, then store what is left with the flag set as needed. count is
+// without HAS_WAITER, caller holds the object lock
+
+static void serve_sem(Sem* p_sem, u32 count) {
+
+	Task* p_task;
+
+	while(!is_list_empty(&p_sem-> head)) {
+
+		p_task = get_list_entry(p_sem-> head.next, Task, blk);
+		if(p_task-> sem_need > count) {
+
+			break;
+		}
+
+		count -= p_task-> sem_need;
+
+		wake_blk_task(p_task);
+	}
+
+	if(is_list_empty(&p_sem-> head) && count) {
+
+		wake_sel_task(&p_sem-> sel);
+	}
+
+	// selecting tasks still need the slow path
+
+	if(!is_list_empty(&p_sem-> head) || (!count && !is_list_empty(&p_sem-> sel))) {
+
+		count |= HAS_WAITER;
+	}
+
+	p_sem-> count = count;
+}
+
+// put n units of a semaphore at once, in one critical section. the units
+// go to the waiters in order for as long as the first one can be served
+
+STATUS put_sem_n(Sem* p_sem, u32 n) {
+
+	u32 count;
+	u32 prev;
+
+	if(NULL == p_sem) {
+
+		return PARAM_ERROR;
+	}
+
+	if(SEM_TYPE != p_sem-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if(!n) {
+
+		return PARAM_ERROR;
+	}
+
+	// fast path, nobody sleeps on the semaphore so skip the wake path
+
+	count = p_sem-> count;
+
+	while(!(count & HAS_WAITER)) {
+
+		if(p_sem-> max && count + n > p_sem-> max) {
+
+			return SEM_FULL;
+		}
+
+		prev = ATOMIC_CAS(&p_sem-> count, count, count + n);
+		if(prev == count) {
+
+			return SUCCESS;
+		}
+
+		count = prev;
+	}
+	
+	// with the flag set only lock holders change the count
+
+	DISABLE_IE();
+	OBJ_LOCK(p_sem);
+
+	count = p_sem-> count & ~HAS_WAITER;
+
+	if(p_sem-> max && count + n > p_sem-> max) {
+
+		OBJ_UNLOCK(p_sem);
+		ENABLE_IE();
+
+		return SEM_FULL;
+	}
+
+	serve_sem(p_sem, count + n);
+
+	OBJ_UNLOCK(p_sem);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// put semaphore
+
+STATUS put_sem(Sem* p_sem) {
+
+	return put_sem_n(p_sem, 1);
+}
+
+// wake every waiter of a semaphore in one pass, they get SEM_FLUSHED and
+// no units. the count stays as it is
+
+STATUS flush_sem(Sem* p_sem) {
+
+	Task* p_task;
+
+	if(NULL == p_sem) {
+
+		return PARAM_ERROR;
+	}
+
+	if(SEM_TYPE != p_sem-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_sem);
+
+	if(!is_list_empty(&p_sem-> head)) {
+
+		while(!is_list_empty(&p_sem-> head)) {
+
+			p_task = get_list_entry(p_sem-> head.next, Task, blk);
+			p_task-> sem_need = 0;
+
+			wake_blk_task(p_task);
+		}
+
+		// units left over now go to the selecting tasks
+
+		if(p_sem-> count & ~HAS_WAITER) {
+
+			wake_sel_task(&p_sem-> sel);
+
+			p_sem-> count &= ~HAS_WAITER;
+
+		}else if(is_list_empty(&p_sem-> sel)) {
+
+			p_sem-> count = 0;
+		}
+	}
+
+	OBJ_UNLOCK(p_sem);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// create mutex
+
+STATUS create_mutex(Mutex* p_mutex) {
+
+	if(NULL == p_mutex) {
+
+		return PARAM_ERROR;
+	}
+
+	p_mutex-> blk_type = MUT_TYPE;
+	p_mutex-> lock = 0;
+	list_init(&p_mutex-> head);
+	p_mutex-> count = 1;
+	p_mutex-> owner = NULL;
+	p_mutex-> nest = 0;
+	p_mutex-> recursive = 0;
+	p_mutex-> ceiling = NO_CEILING;
+	list_init(&p_mutex-> held);
+
+	return SUCCESS;
+}
+
+// let the owner get a mutex again, every get_mutex needs its put_mutex
+
+STATUS set_mutex_recursive(Mutex* p_mutex, u8 recursive) {
+
+	if(NULL == p_mutex) {
+
+		return PARAM_ERROR;
+	}
+
+	if(MUT_TYPE != p_mutex-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	p_mutex-> recursive = recursive;
+
+	return SUCCESS;
+}
+
+// immediate priority ceiling, the owner runs at ceiling as soon as it gets
+// the mutex. with ceiling at the highest prio of its users no other user
+// runs while the mutex is held, so none blocks on it unless the owner
+// blocks itself. tasks above the ceiling get PRIO_CEILING
+
+STATUS set_mutex_ceiling(Mutex* p_mutex, u8 ceiling) {
+
+	if(NULL == p_mutex) {
+
+		return PARAM_ERROR;
+	}
+
+	if(MUT_TYPE != p_mutex-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if(ceiling > NO_CEILING) {
+
+		return PARAM_ERROR;
+	}
+
+	p_mutex-> ceiling = ceiling;
+
+	return SUCCESS;
+}
+
+// raise the new owner to the ceiling, and back when it puts the mutex. on
+// the way back every other boost the owner still has is kept
+
+static void raise_mutex_prio(Mutex* p_mutex) {
+
+	if(NO_CEILING == p_mutex-> ceiling) {
+
+		return;
+	}
+
+	DISABLE_IE();
+	RDY_LOCK();
+
+	list_insert(&current_task-> ceiling_held, &p_mutex-> held);
+
+	if(p_mutex-> ceiling < current_task-> prio) {
+
+		change_task_prio(current_task, p_mutex-> ceiling);
+	}
+
+	RDY_UNLOCK();
+	ENABLE_IE();
+}
+
+static void restore_mutex_prio(Mutex* p_mutex) {
+
+	Channel* p_chan;
+	u8 prio;
+
+	if(is_list_empty(&p_mutex-> held)) {
+
+		return;
+	}
+
+	p_chan = current_task-> ipc_chan;
+
+	DISABLE_IE();
+	if(NULL != p_chan) {
+
+		OBJ_LOCK(p_chan);
+	}
+
+	RDY_LOCK();
+
+	list_delete(&p_mutex-> held);
+	list_init(&p_mutex-> held);
+
+	prio = boost_prio(current_task);
+	if(prio != current_task-> prio) {
+
+		change_task_prio(current_task, prio);
+	}
+
+	RDY_UNLOCK();
+	if(NULL != p_chan) {
+
+		OBJ_UNLOCK(p_chan);
+	}
+
+	ENABLE_IE();
+}
+
+// get mutex
+
+STATUS get_mutex(Mutex* p_mutex, u8 wait) {
+
+	STATUS result;
+	u32 count;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_mutex) {
+
+		return PARAM_ERROR;
+	}
+
+	if(MUT_TYPE != p_mutex-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	// a recursive owner only counts the nesting
+
+	if(p_mutex-> recursive && current_task == p_mutex-> owner) {
+
+		p_mutex-> nest ++;
+
+		return SUCCESS;
+	}
+
+	if(NO_CEILING != p_mutex-> ceiling && current_task-> prio < p_mutex-> ceiling) {
+
+		return PRIO_CEILING;
+	}
+
+	// fast path, count goes from 1 (free) to 0 (owned, no waiter)
+
+	if(ATOMIC_CAS(&p_mutex-> count, 1, 0) == 1) {
+
+		p_mutex-> owner = current_task;
+		raise_mutex_prio(p_mutex);
+
+		return SUCCESS;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_mutex);
+
+	while(1) {
+
+		count = p_mutex-> count;
+
+		if(1 == count) {
+
+			if(ATOMIC_CAS(&p_mutex-> count, 1, 0) == 1) {
+
+				p_mutex-> owner = current_task;
+
+				OBJ_UNLOCK(p_mutex);
+				ENABLE_IE();
+
+				raise_mutex_prio(p_mutex);
+
+				return SUCCESS;
+			}
+
+			continue;
+		}
+
+		if(is_sched_lock()) {
+
+			OBJ_UNLOCK(p_mutex);
+			ENABLE_IE();
+
+			return OS_SCHED_LOCKED;
+		} 
+
+		if(!wait) {
+
+			OBJ_UNLOCK(p_mutex);
+			ENABLE_IE();
+
+			return NOT_WAIT;
+		}
+
+		if(ATOMIC_CAS(&p_mutex-> count, count, count | HAS_WAITER) == count) {
+
+			break;
+		}
+	}
+
+	// put_mutex hands the ownership over before waking us
+
+	result = block_cur_task(&p_mutex-> head, &p_mutex-> lock);
+
+	ENABLE_IE();
+
+	raise_mutex_prio(p_mutex);
+
+	return result;
+}
+
+// pass a released mutex to its first waiter, caller holds the object lock
+
+static void hand_over_mutex(Mutex* p_mutex) {
+
+	Task* p_task;
+
+	if(is_list_empty(&p_mutex->head)) {
+
+		p_mutex-> count = 1;
+
+		return;
+	}
+
+	p_task = get_list_entry(p_mutex->head.next, Task, blk);
+
+	p_mutex-> owner = p_task;
+
+	wake_blk_task(p_task);
+
+	if(is_list_empty(&p_mutex->head)) {
+
+		p_mutex-> count = 0;
+	}
+}
+
+// put mutex
+
+STATUS put_mutex(Mutex* p_mutex) {
+
+	if(NULL == p_mutex) {
+
+		return PARAM_ERROR;
+	}
+
+	if(MUT_TYPE != p_mutex-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if(current_task != p_mutex-> owner) {
+
+		return NOT_MUTEX_OWNER;
+	}
+
+	if(p_mutex-> nest) {
+
+		p_mutex-> nest --;
+
+		return SUCCESS;
+	}
+
+	restore_mutex_prio(p_mutex);
+
+	// fast path, no waiter so release without entering the critical section
+
+	p_mutex-> owner = NULL;
+
+	if(ATOMIC_CAS(&p_mutex-> count, 0, 1) == 0) {
+
+		return SUCCESS;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_mutex);
+
+	hand_over_mutex(p_mutex);
+
+	OBJ_UNLOCK(p_mutex);
+	ENABLE_IE();
+
+	return SUCCESS;	
+}
+
+// create cond, p_mutex guards the predicate waiters sleep on
+
+STATUS create_cond(Cond* p_cond, Mutex* p_mutex) {
+
+	if(NULL == p_cond || NULL == p_mutex) {
+
+		return PARAM_ERROR;
+	}
+
+	p_cond-> blk_type = COND_TYPE;
+	p_cond-> lock = 0;
+	list_init(&p_cond-> head);
+	p_cond-> p_mutex = p_mutex;
+
+	return SUCCESS;
+}
+
+// move a waiter from the cond to its mutex, caller holds both object locks.
+// a free mutex goes to the waiter at once, otherwise it queues up there
+// and put_mutex hands it over later
+
+static void requeue_cond_task(Cond* p_cond, Task* p_task) {
+
+	Mutex* p_mutex;
+	u32 count;
+
+	p_mutex = p_cond-> p_mutex;
+
+	while(1) {
+
+		count = p_mutex-> count;
+
+		if(1 == count) {
+
+			if(ATOMIC_CAS(&p_mutex-> count, 1, 0) == 1) {
+
+				p_mutex-> owner = p_task;
+				wake_blk_task(p_task);
+
+				return;
+			}
+
+			continue;
+		}
+
+		if(ATOMIC_CAS(&p_mutex-> count, count, count | HAS_WAITER) == count) {
+
+			remove_from_blk_queue(p_task);
+			add_to_blk_queue(&p_mutex-> head, &p_mutex-> lock, p_task);
+			p_task-> cond_signaled = 1;
+
+			return;
+		}
+	}
+}
+
+// release the mutex and sleep on the cond in one step, up to timeout ticks.
+// the mutex is held again on return, also after TIMEOUT
+
+STATUS wait_cond(Cond* p_cond, u32 timeout) {
+
+	STATUS result;
+	Mutex* p_mutex;
+	u32 nest;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_cond) {
+
+		return PARAM_ERROR;
+	}
+
+	if(COND_TYPE != p_cond-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	p_mutex = p_cond-> p_mutex;
+
+	if(current_task != p_mutex-> owner) {
+
+		return NOT_MUTEX_OWNER;
+	}
+
+	if(NO_WAIT == timeout) {
+
+		return NOT_WAIT;
+	}
+
+	if(is_sched_lock()) {
+
+		return OS_SCHED_LOCKED;
+	}
+
+	// a recursive mutex is dropped as a whole and comes back as deep
+
+	nest = p_mutex-> nest;
+	p_mutex-> nest = 0;
+
+	restore_mutex_prio(p_mutex);
+
+	DISABLE_IE();
+
+	current_task-> wait_timeout = 0;
+	current_task-> cond_signaled = 0;
+
+	if(WAIT_FOREVER != timeout) {
+
+		current_task-> wait_timer.val = timeout;
+		activate_timer(&current_task-> wait_timer);
+	}
+
+	// the mutex is dropped under the cond lock, so a signal between the
+	// release and the block can not get lost
+
+	OBJ_LOCK(p_cond);
+
+	p_mutex-> owner = NULL;
+
+	if(ATOMIC_CAS(&p_mutex-> count, 0, 1) != 0) {
+
+		OBJ_LOCK(p_mutex);
+		hand_over_mutex(p_mutex);
+		OBJ_UNLOCK(p_mutex);
+	}
+
+	current_task-> cond_wait = p_cond;
+
+	result = block_cur_task(&p_cond-> head, &p_cond-> lock);
+
+	current_task-> cond_wait = NULL;
+
+	ENABLE_IE();
+
+	if(WAIT_FOREVER != timeout) {
+
+		deactivate_timer(&current_task-> wait_timer);
+	}
+
+	if(current_task == p_mutex-> owner) {
+
+		raise_mutex_prio(p_mutex);
+
+	}else {
+
+		// timed out, on the cond list or after the signal moved us to the mutex
+
+		if(!current_task-> cond_signaled) {
+
+			result = TIMEOUT;
+		}
+
+		get_mutex(p_mutex, 1);
+	}
+
+	p_mutex-> nest = nest;
+
+	return result;
+}
+
+// wake the first waiter of a cond, it goes on with the mutex held
+
+STATUS signal_cond(Cond* p_cond) {
+
+	Task* p_task;
+
+	if(NULL == p_cond) {
+
+		return PARAM_ERROR;
+	}
+
+	if(COND_TYPE != p_cond-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_cond);
+
+	if(!is_list_empty(&p_cond-> head)) {
+
+		OBJ_LOCK(p_cond-> p_mutex);
+
+		p_task = get_list_entry(p_cond-> head.next, Task, blk);
+		requeue_cond_task(p_cond, p_task);
+
+		OBJ_UNLOCK(p_cond-> p_mutex);
+	}
+
+	OBJ_UNLOCK(p_cond);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// wake all waiters of a cond. only the first can get the mutex, so the rest
+// move over to the mutex wait list and run one by one as it is put
+
+STATUS broadcast_cond(Cond* p_cond) {
+
+	Task* p_task;
+
+	if(NULL == p_cond) {
+
+		return PARAM_ERROR;
+	}
+
+	if(COND_TYPE != p_cond-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_cond);
+
+	if(!is_list_empty(&p_cond-> head)) {
+
+		OBJ_LOCK(p_cond-> p_mutex);
+
+		while(!is_list_empty(&p_cond-> head)) {
+
+			p_task = get_list_entry(p_cond-> head.next, Task, blk);
+			requeue_cond_task(p_cond, p_task);
+		}
+
+		OBJ_UNLOCK(p_cond-> p_mutex);
+	}
+
+	OBJ_UNLOCK(p_cond);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// create barrier for parties tasks
+
+STATUS create_barrier(Barrier* p_bar, u32 parties) {
+
+	if(NULL == p_bar || !parties) {
+
+		return PARAM_ERROR;
+	}
+
+	p_bar-> blk_type = BARRIER_TYPE;
+	p_bar-> lock = 0;
+	list_init(&p_bar-> head);
+	p_bar-> parties = parties;
+	p_bar-> count = 0;
+	p_bar-> gen = 0;
+
+	return SUCCESS;
+}
+
+// arrive at a barrier. the last party starts the next phase and wakes all
+// others in the same critical section. the others spin up to spin rounds
+// for the phase to change, then sleep on the barrier
+
+static STATUS arrive_barrier(Barrier* p_bar, u32 spin) {
+
+	STATUS result;
+	Task* p_task;
+	u32 gen;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_bar) {
+
+		return PARAM_ERROR;
+	}
+
+	if(BARRIER_TYPE != p_bar-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_bar);
+
+	gen = p_bar-> gen;
+
+	if(p_bar-> count + 1 == p_bar-> parties) {
+
+		p_bar-> count = 0;
+		p_bar-> gen = gen + 1;
+
+		while(!is_list_empty(&p_bar-> head)) {
+
+			p_task = get_list_entry(p_bar-> head.next, Task, blk);
+			wake_blk_task(p_task);
+		}
+
+		OBJ_UNLOCK(p_bar);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	if(is_sched_lock()) {
+
+		OBJ_UNLOCK(p_bar);
+		ENABLE_IE();
+
+		return OS_SCHED_LOCKED;
+	}
+
+	p_bar-> count ++;
+
+	if(spin) {
+
+		OBJ_UNLOCK(p_bar);
+		ENABLE_IE();
+
+		// the last party runs on another cpu, gen changes without a lock
+
+		while(spin --) {
+
+			if(gen != *(volatile u32*) &p_bar-> gen) {
+
+				return SUCCESS;
+			}
+
+			CPU_RELAX();
+		}
+
+		DISABLE_IE();
+		OBJ_LOCK(p_bar);
+
+		if(gen != p_bar-> gen) {
+
+			OBJ_UNLOCK(p_bar);
+			ENABLE_IE();
+
+			return SUCCESS;
+		}
+	}
+
+	result = block_cur_task(&p_bar-> head, &p_bar-> lock);
+
+	ENABLE_IE();
+
+	return result;
+}
+
+// wait at a barrier until all parties arrived
+
+STATUS wait_barrier(Barrier* p_bar) {
+
+	return arrive_barrier(p_bar, 0);
+}
+
+// like wait_barrier, but busy wait up to spin rounds before sleeping. only
+// pays off when the other parties run on other cpus of an smp host
+
+STATUS spin_barrier(Barrier* p_bar, u32 spin) {
+
+	return arrive_barrier(p_bar, spin);
+}
+
+// create rwlock
+
+STATUS create_rwlock(Rwlock* p_rw) {
+
+	if(NULL == p_rw) {
+
+		return PARAM_ERROR;
+	}
+
+	p_rw-> blk_type = RW_TYPE;
+	p_rw-> lock = 0;
+	list_init(&p_rw-> head);
+	list_init(&p_rw-> wr);
+	p_rw-> count = 0;
+	p_rw-> owner = NULL;
+
+	return SUCCESS;
+}
+
+// hand the rwlock to the waiters once it is free, caller holds the object
+// lock and HAS_WAITER is set. the side that did not just release goes first,
+// so the last reader hands over to a writer and a writer to all waiting
+// readers. the flag stays while anybody still waits
+
+static void wake_rwlock(Rwlock* p_rw, u32 from_writer) {
+
+	Task* p_task;
+	u32 count;
+
+	count = 0;
+
+	if(!is_list_empty(&p_rw-> head) && (from_writer || is_list_empty(&p_rw-> wr))) {
+
+		while(!is_list_empty(&p_rw-> head)) {
+
+			p_task = get_list_entry(p_rw-> head.next, Task, blk);
+			wake_blk_task(p_task);
+			count ++;
+		}
+
+		p_rw-> owner = NULL;
+
+	}else if(!is_list_empty(&p_rw-> wr)) {
+
+		p_task = get_list_entry(p_rw-> wr.next, Task, blk);
+		wake_blk_task(p_task);
+
+		p_rw-> owner = p_task;
+		count = RW_WRITER;
+
+	}else {
+
+		p_rw-> owner = NULL;
+	}
+
+	if(!is_list_empty(&p_rw-> head) || !is_list_empty(&p_rw-> wr)) {
+
+		count |= HAS_WAITER;
+	}
+
+	p_rw-> count = count;
+}
+
+// get rwlock for reading, shared with other readers
+
+STATUS get_rwlock_read(Rwlock* p_rw, u8 wait) {
+
+	STATUS result;
+	u32 count;
+	u32 prev;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_rw) {
+
+		return PARAM_ERROR;
+	}
+
+	if(RW_TYPE != p_rw-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	// fast path, count one more reader while no writer holds or waits
+
+	count = p_rw-> count;
+
+	while(!(count & (RW_WRITER | HAS_WAITER))) {
+
+		prev = ATOMIC_CAS(&p_rw-> count, count, count + 1);
+		if(prev == count) {
+
+			return SUCCESS;
+		}
+
+		count = prev;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_rw);
+
+	while(1) {
+
+		count = p_rw-> count;
+
+		// with waiters around only a free lock lets a reader in
+
+		if(!(count & RW_WRITER) && is_list_empty(&p_rw-> wr)) {
+
+			if(ATOMIC_CAS(&p_rw-> count, count, count + 1) == count) {
+
+				OBJ_UNLOCK(p_rw);
+				ENABLE_IE();
+
+				return SUCCESS;
+			}
+
+			continue;
+		}
+
+		if(is_sched_lock()) {
+
+			OBJ_UNLOCK(p_rw);
+			ENABLE_IE();
+
+			return OS_SCHED_LOCKED;
+		}
+
+		if(!wait) {
+
+			OBJ_UNLOCK(p_rw);
+			ENABLE_IE();
+
+			return NOT_WAIT;
+		}
+
+		if(ATOMIC_CAS(&p_rw-> count, count, count | HAS_WAITER) == count) {
+
+			break;
+		}
+	}
+
+	// wake_rwlock counts us as a reader before waking us
+
+	result = block_cur_task(&p_rw-> head, &p_rw-> lock);
+
+	ENABLE_IE();
+
+	return result;
+}
+
+// put rwlock after reading
+
+STATUS put_rwlock_read(Rwlock* p_rw) {
+
+	u32 count;
+	u32 prev;
+
+	if(NULL == p_rw) {
+
+		return PARAM_ERROR;
+	}
+
+	if(RW_TYPE != p_rw-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	// fast path, nobody waits so just drop the reader count
+
+	count = p_rw-> count;
+
+	while(!(count & HAS_WAITER)) {
+
+		if(!count || (count & RW_WRITER)) {
+
+			return NOT_MUTEX_OWNER;
+		}
+
+		prev = ATOMIC_CAS(&p_rw-> count, count, count - 1);
+		if(prev == count) {
+
+			return SUCCESS;
+		}
+
+		count = prev;
+	}
+
+	// with the flag set only lock holders change the count
+
+	DISABLE_IE();
+	OBJ_LOCK(p_rw);
+
+	count = p_rw-> count;
+
+	if((count & RW_WRITER) || !(count & ~HAS_WAITER)) {
+
+		OBJ_UNLOCK(p_rw);
+		ENABLE_IE();
+
+		return NOT_MUTEX_OWNER;
+	}
+
+	p_rw-> count = count - 1;
+
+	// the last reader lets the waiting writer in
+
+	if(!((count - 1) & ~HAS_WAITER)) {
+
+		wake_rwlock(p_rw, 0);
+	}
+
+	OBJ_UNLOCK(p_rw);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// get rwlock for writing, exclusive
+
+STATUS get_rwlock_write(Rwlock* p_rw, u8 wait) {
+
+	STATUS result;
+	u32 count;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_rw) {
+
+		return PARAM_ERROR;
+	}
+
+	if(RW_TYPE != p_rw-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	// fast path, count goes from 0 (free) to RW_WRITER
+
+	if(ATOMIC_CAS(&p_rw-> count, 0, RW_WRITER) == 0) {
+
+		p_rw-> owner = current_task;
+
+		return SUCCESS;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_rw);
+
+	while(1) {
+
+		count = p_rw-> count;
+
+		if(!(count & ~HAS_WAITER)) {
+
+			if(ATOMIC_CAS(&p_rw-> count, count, count | RW_WRITER) == count) {
+
+				p_rw-> owner = current_task;
+
+				OBJ_UNLOCK(p_rw);
+				ENABLE_IE();
+
+				return SUCCESS;
+			}
+
+			continue;
+		}
+
+		if(is_sched_lock()) {
+
+			OBJ_UNLOCK(p_rw);
+			ENABLE_IE();
+
+			return OS_SCHED_LOCKED;
+		}
+
+		if(!wait) {
+
+			OBJ_UNLOCK(p_rw);
+			ENABLE_IE();
+
+			return NOT_WAIT;
+		}
+
+		// once the flag is set new readers queue behind us
+
+		if(ATOMIC_CAS(&p_rw-> count, count, count | HAS_WAITER) == count) {
+
+			break;
+		}
+	}
+
+	// wake_rwlock hands the ownership over before waking us
+
+	result = block_cur_task(&p_rw-> wr, &p_rw-> lock);
+
+	ENABLE_IE();
+
+	return result;
+}
+
+// put rwlock after writing
+
+STATUS put_rwlock_write(Rwlock* p_rw) {
+
+	if(NULL == p_rw) {
+
+		return PARAM_ERROR;
+	}
+
+	if(RW_TYPE != p_rw-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if(current_task != p_rw-> owner) {
+
+		return NOT_MUTEX_OWNER;
+	}
+
+	// fast path, no waiter so release without entering the critical section
+
+	p_rw-> owner = NULL;
+
+	if(ATOMIC_CAS(&p_rw-> count, RW_WRITER, 0) == RW_WRITER) {
+
+		return SUCCESS;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_rw);
+
+	wake_rwlock(p_rw, 1);
+
+	OBJ_UNLOCK(p_rw);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// create mail
+
+STATUS create_mail(Mailbox* p_box, void* msg) {
+
+	if(NULL == p_box) {
+
+		return PARAM_ERROR;
+	}
+
+	p_box-> blk_type = MAIL_TYPE;
+	p_box-> lock = 0;
+	list_init(&p_box-> head);
+	list_init(&p_box-> sel);
+	p_box-> msg = msg;
+	p_box-> overwrite = 0;
+	p_box-> seq = 0;
+
+	return SUCCESS;
+}
+
+
+// change the msg of a mailbox, caller holds the object lock. seq is odd
+// while the change is in progress so peek_mail() can retry, the write
+// barriers keep the msg store between the two seq stores
+
+static void set_mail_msg(Mailbox* p_box, void* msg) {
+
+	*(volatile u32*) &p_box-> seq = p_box-> seq + 1;
+	SMP_WMB();
+	*(void* volatile*) &p_box-> msg = msg;
+	SMP_WMB();
+	*(volatile u32*) &p_box-> seq = p_box-> seq + 1;
+}
+
+// in overwrite mode put_mail never fails with MSG_EXIST, the new msg
+// replaces one nobody has taken yet. meant for latest value data
+
+STATUS set_mail_overwrite(Mailbox* p_box, u8 overwrite) {
+
+	if(NULL == p_box) {
+
+		return PARAM_ERROR;
+	}
+
+	if(MAIL_TYPE != p_box-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	p_box-> overwrite = overwrite;
+
+	return SUCCESS;
+}
+
+// read the msg of a mailbox without taking it and without any lock, so
+// it works from isr as well. *p_seq grows by 2 with every change, a reader
+// can compare it to tell a fresh msg from one it has seen
+
+STATUS peek_mail(Mailbox* p_box, void** pp_msg, u32* p_seq) {
+
+	void* msg;
+	u32 seq;
+
+	if(NULL == p_box || NULL == pp_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	if(MAIL_TYPE != p_box-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	// the read barriers pair with the write barriers in set_mail_msg
+
+	do {
+
+		seq = *(volatile u32*) &p_box-> seq;
+		SMP_RMB();
+		msg = *(void* volatile*) &p_box-> msg;
+		SMP_RMB();
+
+	}while((seq & 1) || seq != *(volatile u32*) &p_box-> seq);
+
+	if(NULL != p_seq) {
+
+		*p_seq = seq;
+	}
+
+	if(NULL == msg) {
+
+		return NOT_WAIT;
+	}
+
+	*pp_msg = msg;
+
+	return SUCCESS;
+}
+
+// get mail
+
+STATUS get_mail(Mailbox* p_box, void** pp_msg, u8 wait) {
+
+	STATUS result;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_box) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == pp_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	if(MAIL_TYPE != p_box-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_box);
+	if(p_box-> msg) {
+
+		*pp_msg = p_box-> msg;
+		set_mail_msg(p_box, NULL);
+		OBJ_UNLOCK(p_box);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	if(is_sched_lock()) {
+
+		OBJ_UNLOCK(p_box);
+		ENABLE_IE();
+
+		return OS_SCHED_LOCKED;
+	}
+
+	if(!wait) {
+
+		OBJ_UNLOCK(p_box);
+		ENABLE_IE();
+
+		return NOT_WAIT;
+	}
+
+	result = block_cur_task(&p_box-> head, &p_box-> lock);
+
+	ENABLE_IE();
+
+	if(SUCCESS != result) {
+
+		return result;
+	}
+
+	DISABLE_IE();
+
+	*pp_msg = current_task-> msg;
+
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+
+// put mail
+
+STATUS put_mail(Mailbox* p_box, void* msg) {
+
+	Task* p_task;
+
+	if(NULL == p_box) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == msg) {
+
+		return PARAM_ERROR;
+	}
+
+	if(MAIL_TYPE != p_box-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_box);
+
+	if(p_box-> msg) {
+
+		if(!p_box-> overwrite) {
+
+			OBJ_UNLOCK(p_box);
+			ENABLE_IE();
+
+			return MSG_EXIST;
+		}
+
+		set_mail_msg(p_box, msg);
+
+		OBJ_UNLOCK(p_box);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	if(is_list_empty(&p_box->head)){
+
+		set_mail_msg(p_box, msg);
+		wake_sel_task(&p_box-> sel);
+
+		OBJ_UNLOCK(p_box);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	p_task = get_list_entry(p_box->head.next, Task, blk);
+
+	p_task-> msg = msg;
+
+	wake_blk_task(p_task);
+
+	OBJ_UNLOCK(p_box);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// create message buffer
+
+STATUS create_msg_buf(Msgbuf* p_msg_buf, void** pp_msg, u32 size) {
+
+	if(NULL == p_msg_buf) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == pp_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!size) {
+
+		return PARAM_ERROR;
+	}
+
+	p_msg_buf-> blk_type = BUF_TYPE;
+	p_msg_buf-> lock = 0;
+	list_init(&p_msg_buf->head);
+	list_init(&p_msg_buf-> sel);
+	p_msg_buf-> pp_msg = pp_msg;
+	p_msg_buf-> size = size;
+
+	p_msg_buf-> count = 0;
+	p_msg_buf-> start = 0;
+	p_msg_buf-> end   = 0;
+
+	return SUCCESS;
+}
+
+// get message from buffer
+
+STATUS get_msg_buf(Msgbuf* p_msg_buf, void** pp_msg, u8 wait) {
+
+	STATUS result;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_msg_buf) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == pp_msg){
+
+		return PARAM_ERROR;
+	}
+
+	if(BUF_TYPE != p_msg_buf-> blk_type){
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_msg_buf);
+
+	if(p_msg_buf-> count) {
+
+		*pp_msg = p_msg_buf->pp_msg[p_msg_buf-> end];
+
+		p_msg_buf-> end ++;
+
+		if(p_msg_buf-> end == p_msg_buf-> size){
+
+			p_msg_buf-> end = 0;
+		}
+
+		p_msg_buf-> count --;
+
+		OBJ_UNLOCK(p_msg_buf);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	if(is_sched_lock()) {
+
+		OBJ_UNLOCK(p_msg_buf);
+		ENABLE_IE();
+
+		return OS_SCHED_LOCKED;
+	}
+
+	if(!wait) {
+
+		OBJ_UNLOCK(p_msg_buf);
+		ENABLE_IE();
+
+		return NOT_WAIT;
+	}
+
+	result = block_cur_task(&p_msg_buf-> head, &p_msg_buf-> lock);
+
+	ENABLE_IE();
+
+	if(SUCCESS != result) {
+
+		return result;
+	}
+
+	DISABLE_IE();
+	*pp_msg = current_task-> buf_msg;
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// put message buffer
+
+STATUS put_msg_buf(Msgbuf* p_msg_buf, void* p_msg){
+
+	Task* p_task;
+
+	if(NULL == p_msg_buf){
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	if(BUF_TYPE != p_msg_buf-> blk_type){
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_msg_buf);
+
+	if(is_list_empty(&p_msg_buf-> head)){
+
+		if(p_msg_buf-> size == p_msg_buf-> count){
+
+			OBJ_UNLOCK(p_msg_buf);
+			ENABLE_IE();
+
+			return MSG_FULL;
+		}
+
+		p_msg_buf-> pp_msg[p_msg_buf-> start] = p_msg;
+
+		p_msg_buf-> start ++;
+
+		if(p_msg_buf-> start == p_msg_buf-> size) {
+
+			p_msg_buf-> start = 0;
+		}
+
+		p_msg_buf-> count ++;
+
+		wake_sel_task(&p_msg_buf-> sel);
+
+		OBJ_UNLOCK(p_msg_buf);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	p_task = get_list_entry(p_msg_buf->head.next, Task, blk);
+
+	p_task-> buf_msg = p_msg;
+
+	wake_blk_task(p_task);
+
+	OBJ_UNLOCK(p_msg_buf);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// put message at the front of the buffer, it is taken before everything
+// already queued. meant for urgent control messages
+
+STATUS put_msg_buf_front(Msgbuf* p_msg_buf, void* p_msg){
+
+	Task* p_task;
+
+	if(NULL == p_msg_buf){
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	if(BUF_TYPE != p_msg_buf-> blk_type){
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_msg_buf);
+
+	if(is_list_empty(&p_msg_buf-> head)){
+
+		if(p_msg_buf-> size == p_msg_buf-> count){
+
+			OBJ_UNLOCK(p_msg_buf);
+			ENABLE_IE();
+
+			return MSG_FULL;
+		}
+
+		// step the read position back and store there
+
+		if(0 == p_msg_buf-> end) {
+
+			p_msg_buf-> end = p_msg_buf-> size;
+		}
+
+		p_msg_buf-> end --;
+
+		p_msg_buf-> pp_msg[p_msg_buf-> end] = p_msg;
+
+		p_msg_buf-> count ++;
+
+		wake_sel_task(&p_msg_buf-> sel);
+
+		OBJ_UNLOCK(p_msg_buf);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	p_task = get_list_entry(p_msg_buf->head.next, Task, blk);
+
+	p_task-> buf_msg = p_msg;
+
+	wake_blk_task(p_task);
+
+	OBJ_UNLOCK(p_msg_buf);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// create priority message buffer, p_node gives room for size messages
+
+STATUS create_prio_msg_buf(PrioMsgbuf* p_buf, MsgNode* p_node, u32 size) {
+
+	u32 i;
+
+	if(NULL == p_buf) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_node) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!size) {
+
+		return PARAM_ERROR;
+	}
+
+	p_buf-> blk_type = PRIO_BUF_TYPE;
+	p_buf-> lock = 0;
+	list_init(&p_buf-> head);
+	list_init(&p_buf-> sel);
+
+	p_buf-> free = NULL;
+
+	for(i = size; i > 0; i --) {
+
+		p_node[i - 1].next = p_buf-> free;
+		p_buf-> free = &p_node[i - 1];
+	}
+
+	for(i = 0; i < MSG_PRIO_NUM; i ++) {
+
+		p_buf-> first[i] = NULL;
+		p_buf-> last[i] = NULL;
+	}
+
+	p_buf-> bitmap = 0;
+	p_buf-> count = 0;
+
+	return SUCCESS;
+}
+
+// get the oldest message of the most urgent level
+
+STATUS get_prio_msg_buf(PrioMsgbuf* p_buf, void** pp_msg, u8 wait) {
+
+	MsgNode* p_node;
+	STATUS result;
+	u32 prio;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_buf) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == pp_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	if(PRIO_BUF_TYPE != p_buf-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_buf);
+
+	if(p_buf-> bitmap) {
+
+		prio = find_first_bit(p_buf-> bitmap);
+
+		p_node = p_buf-> first[prio];
+		p_buf-> first[prio] = p_node-> next;
+
+		if(NULL == p_node-> next) {
+
+			p_buf-> last[prio] = NULL;
+			p_buf-> bitmap &= ~(1 << prio);
+		}
+
+		*pp_msg = p_node-> msg;
+
+		p_node-> next = p_buf-> free;
+		p_buf-> free = p_node;
+		p_buf-> count --;
+
+		OBJ_UNLOCK(p_buf);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	if(is_sched_lock()) {
+
+		OBJ_UNLOCK(p_buf);
+		ENABLE_IE();
+
+		return OS_SCHED_LOCKED;
+	}
+
+	if(!wait) {
+
+		OBJ_UNLOCK(p_buf);
+		ENABLE_IE();
+
+		return NOT_WAIT;
+	}
+
+	result = block_cur_task(&p_buf-> head, &p_buf-> lock);
+
+	ENABLE_IE();
+
+	if(SUCCESS != result) {
+
+		return result;
+	}
+
+	DISABLE_IE();
+	*pp_msg = current_task-> buf_msg;
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// put message at level prio, behind the messages already at that level
+
+STATUS put_prio_msg_buf(PrioMsgbuf* p_buf, void* p_msg, u8 prio) {
+
+	MsgNode* p_node;
+	Task* p_task;
+
+	if(NULL == p_buf) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	if(prio >= MSG_PRIO_NUM) {
+
+		return PARAM_ERROR;
+	}
+
+	if(PRIO_BUF_TYPE != p_buf-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_buf);
+
+	if(is_list_empty(&p_buf-> head)) {
+
+		p_node = p_buf-> free;
+		if(NULL == p_node) {
+
+			OBJ_UNLOCK(p_buf);
+			ENABLE_IE();
+
+			return MSG_FULL;
+		}
+
+		p_buf-> free = p_node-> next;
+
+		p_node-> msg = p_msg;
+		p_node-> next = NULL;
+
+		if(NULL == p_buf-> last[prio]) {
+
+			p_buf-> first[prio] = p_node;
+
+		}else {
+
+			p_buf-> last[prio]-> next = p_node;
+		}
+
+		p_buf-> last[prio] = p_node;
+		p_buf-> bitmap |= 1 << prio;
+		p_buf-> count ++;
+
+		wake_sel_task(&p_buf-> sel);
+
+		OBJ_UNLOCK(p_buf);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	p_task = get_list_entry(p_buf-> head.next, Task, blk);
+
+	p_task-> buf_msg = p_msg;
+
+	wake_blk_task(p_task);
+
+	OBJ_UNLOCK(p_buf);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+
+// copy one queue item, word by word when both sides allow it
+
+static void copy_item(void* p_dst, const void* p_src, u32 size) {
+
+	u32* p_dst32;
+	const u32* p_src32;
+	u8* p_dst8;
+	const u8* p_src8;
+
+	if(!(((u32) p_dst | (u32) p_src | size) & 3)) {
+
+		p_dst32 = (u32*) p_dst;
+		p_src32 = (const u32*) p_src;
+
+		for(size >>= 2; size; size --) {
+
+			*p_dst32 ++ = *p_src32 ++;
+		}
+
+		return;
+	}
+
+	p_dst8 = (u8*) p_dst;
+	p_src8 = (const u8*) p_src;
+
+	while(size --) {
+
+		*p_dst8 ++ = *p_src8 ++;
+	}
+}
+
+// create queue, p_buf holds size items of item_size bytes
+
+STATUS create_queue(Queue* p_queue, void* p_buf, u32 item_size, u32 size) {
+
+	if(NULL == p_queue) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_buf) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!item_size || !size) {
+
+		return PARAM_ERROR;
+	}
+
+	p_queue-> blk_type = QUEUE_TYPE;
+	p_queue-> lock = 0;
+	list_init(&p_queue-> head);
+	p_queue-> p_buf = (u8*) p_buf;
+	p_queue-> item_size = item_size;
+	p_queue-> size = size;
+
+	p_queue-> count = 0;
+	p_queue-> start = 0;
+	p_queue-> end = 0;
+
+	return SUCCESS;
+}
+
+// get an item from queue, it is copied to p_item
+
+STATUS get_queue(Queue* p_queue, void* p_item, u8 wait) {
+
+	STATUS result;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_queue) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_item) {
+
+		return PARAM_ERROR;
+	}
+
+	if(QUEUE_TYPE != p_queue-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_queue);
+
+	if(p_queue-> count) {
+
+		copy_item(p_item, p_queue-> p_buf + p_queue-> end * p_queue-> item_size, p_queue-> item_size);
+
+		p_queue-> end ++;
+
+		if(p_queue-> end == p_queue-> size) {
+
+			p_queue-> end = 0;
+		}
+
+		p_queue-> count --;
+
+		OBJ_UNLOCK(p_queue);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	if(is_sched_lock()) {
+
+		OBJ_UNLOCK(p_queue);
+		ENABLE_IE();
+
+		return OS_SCHED_LOCKED;
+	}
+
+	if(!wait) {
+
+		OBJ_UNLOCK(p_queue);
+		ENABLE_IE();
+
+		return NOT_WAIT;
+	}
+
+	// put_queue() copies straight into p_item
+
+	current_task-> queue_item = p_item;
+
+	result = block_cur_task(&p_queue-> head, &p_queue-> lock);
+
+	ENABLE_IE();
+
+	return result;
+}
+
+// put an item into queue, a waiting task gets it copied to its destination
+// without passing through the ring
+
+STATUS put_queue(Queue* p_queue, const void* p_item) {
+
+	Task* p_task;
+
+	if(NULL == p_queue) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_item) {
+
+		return PARAM_ERROR;
+	}
+
+	if(QUEUE_TYPE != p_queue-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_queue);
+
+	if(is_list_empty(&p_queue-> head)) {
+
+		if(p_queue-> size == p_queue-> count) {
+
+			OBJ_UNLOCK(p_queue);
+			ENABLE_IE();
+
+			return MSG_FULL;
+		}
+
+		copy_item(p_queue-> p_buf + p_queue-> start * p_queue-> item_size, p_item, p_queue-> item_size);
+
+		p_queue-> start ++;
+
+		if(p_queue-> start == p_queue-> size) {
+
+			p_queue-> start = 0;
+		}
+
+		p_queue-> count ++;
+
+		OBJ_UNLOCK(p_queue);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	p_task = get_list_entry(p_queue-> head.next, Task, blk);
+
+	copy_item(p_task-> queue_item, p_item, p_queue-> item_size);
+
+	wake_blk_task(p_task);
+
+	OBJ_UNLOCK(p_queue);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// create stream, size must be a power of two. a reader sleeps until
+// trigger bytes are there, or fewer if it asked for less
+
+STATUS create_stream(Stream* p_stream, void* p_buf, u32 size, u32 trigger) {
+
+	if(NULL == p_stream) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_buf) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!size || (size & (size - 1))) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!trigger || trigger > size) {
+
+		return PARAM_ERROR;
+	}
+
+	p_stream-> blk_type = STREAM_TYPE;
+	p_stream-> lock = 0;
+	list_init(&p_stream-> head);
+	p_stream-> p_buf = (u8*) p_buf;
+	p_stream-> size = size;
+	p_stream-> trigger = trigger;
+	p_stream-> in = 0;
+	p_stream-> out = 0;
+	p_stream-> wait = 0;
+	p_stream-> need = 0;
+
+	return SUCCESS;
+}
+
+// wake the reader once the trigger level is reached, the writer only
+// gets here when the reader said it sleeps
+
+static void wake_stream_reader(Stream* p_stream) {
+
+	Task* p_task;
+
+	// in is published, now look at wait. pairs with the barrier in
+	// wait_stream, so one side always sees the other
+
+	SMP_MB();
+
+	if(!p_stream-> wait) {
+
+		return;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_stream);
+
+	if(p_stream-> wait && !is_list_empty(&p_stream-> head)) {
+
+		p_task = get_list_entry(p_stream-> head.next, Task, blk);
+
+		if(p_stream-> in - p_stream-> out >= p_stream-> need) {
+
+			p_stream-> wait = 0;
+			wake_blk_task(p_task);
+		}
+	}
+
+	OBJ_UNLOCK(p_stream);
+	ENABLE_IE();
+}
+
+// sleep until need bytes can be read, the writer checks wait after moving
+// in, so one of the two always sees the other
+
+static STATUS wait_stream(Stream* p_stream, u32 need, u8 wait) {
+
+	STATUS result;
+
+	if(p_stream-> in - p_stream-> out >= need) {
+
+		return SUCCESS;
+	}
+
+	if(!wait) {
+
+		return NOT_WAIT;
+	}
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(is_sched_lock()) {
+
+		return OS_SCHED_LOCKED;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_stream);
+
+	p_stream-> need = need;
+	p_stream-> wait = 1;
+
+	SMP_MB();
+
+	if(p_stream-> in - p_stream-> out >= need) {
+
+		p_stream-> wait = 0;
+
+		OBJ_UNLOCK(p_stream);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	result = block_cur_task(&p_stream-> head, &p_stream-> lock);
+
+	ENABLE_IE();
+
+	return result;
+}
+
+// reserve the contiguous free space at the write position, the caller
+// fills up to *p_len bytes at *pp_buf in place and commits them
+
+STATUS reserve_stream(Stream* p_stream, void** pp_buf, u32* p_len) {
+
+	u32 pos;
+	u32 len;
+
+	if(NULL == p_stream || NULL == pp_buf || NULL == p_len) {
+
+		return PARAM_ERROR;
+	}
+
+	if(STREAM_TYPE != p_stream-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	pos = p_stream-> in & (p_stream-> size - 1);
+	len = p_stream-> size - (p_stream-> in - p_stream-> out);
+
+	if(len > p_stream-> size - pos) {
+
+		len = p_stream-> size - pos;
+	}
+
+	*pp_buf = p_stream-> p_buf + pos;
+	*p_len = len;
+
+	return len ? SUCCESS : MSG_FULL;
+}
+
+// publish len bytes written in place after reserve_stream()
+
+STATUS commit_stream(Stream* p_stream, u32 len) {
+
+	if(NULL == p_stream) {
+
+		return PARAM_ERROR;
+	}
+
+	if(STREAM_TYPE != p_stream-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if(len > p_stream-> size - (p_stream-> in - p_stream-> out)) {
+
+		return PARAM_ERROR;
+	}
+
+	// the data goes out before the index that publishes it
+
+	SMP_WMB();
+	p_stream-> in += len;
+
+	wake_stream_reader(p_stream);
+
+	return SUCCESS;
+}
+
+// write up to len bytes, *p_len tells how many fitted. may be called from isr
+
+STATUS write_stream(Stream* p_stream, const void* p_data, u32 len, u32* p_len) {
+
+	u32 pos;
+	u32 first;
+
+	if(NULL == p_stream || NULL == p_data || NULL == p_len) {
+
+		return PARAM_ERROR;
+	}
+
+	if(STREAM_TYPE != p_stream-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if(len > p_stream-> size - (p_stream-> in - p_stream-> out)) {
+
+		len = p_stream-> size - (p_stream-> in - p_stream-> out);
+	}
+
+	pos = p_stream-> in & (p_stream-> size - 1);
+
+	first = p_stream-> size - pos;
+	if(first > len) {
+
+		first = len;
+	}
+
+	copy_item(p_stream-> p_buf + pos, p_data, first);
+	copy_item(p_stream-> p_buf, (const u8*) p_data + first, len - first);
+
+	*p_len = len;
+
+	SMP_WMB();
+	p_stream-> in += len;
+
+	wake_stream_reader(p_stream);
+
+	return len ? SUCCESS : MSG_FULL;
+}
+
+// look at the contiguous data at the read position without taking it,
+// waits for the trigger level first. consume_stream() frees it
+
+STATUS peek_stream(Stream* p_stream, void** pp_buf, u32* p_len, u8 wait) {
+
+	STATUS result;
+	u32 pos;
+	u32 len;
+
+	if(NULL == p_stream || NULL == pp_buf || NULL == p_len) {
+
+		return PARAM_ERROR;
+	}
+
+	if(STREAM_TYPE != p_stream-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	result = wait_stream(p_stream, p_stream-> trigger, wait);
+	if(SUCCESS != result && (NOT_WAIT != result || p_stream-> in == p_stream-> out)) {
+
+		return result;
+	}
+
+	pos = p_stream-> out & (p_stream-> size - 1);
+	len = p_stream-> in - p_stream-> out;
+
+	if(len > p_stream-> size - pos) {
+
+		len = p_stream-> size - pos;
+	}
+
+	// the data is read only after the index that published it
+
+	SMP_RMB();
+
+	*pp_buf = p_stream-> p_buf + pos;
+	*p_len = len;
+
+	return SUCCESS;
+}
+
+// free len bytes at the read position after peek_stream()
+
+STATUS consume_stream(Stream* p_stream, u32 len) {
+
+	if(NULL == p_stream) {
+
+		return PARAM_ERROR;
+	}
+
+	if(STREAM_TYPE != p_stream-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if(len > p_stream-> in - p_stream-> out) {
+
+		return PARAM_ERROR;
+	}
+
+	// finish reading the data before the writer may reuse the space
+
+	SMP_MB();
+	p_stream-> out += len;
+
+	return SUCCESS;
+}
+
+// read up to len bytes, waiting for the trigger level or len bytes if
+// that is less. *p_len tells how many were read
+
+STATUS read_stream(Stream* p_stream, void* p_data, u32 len, u32* p_len, u8 wait) {
+
+	STATUS result;
+	u32 avail;
+	u32 pos;
+	u32 first;
+
+	if(NULL == p_stream || NULL == p_data || NULL == p_len) {
+
+		return PARAM_ERROR;
+	}
+
+	if(STREAM_TYPE != p_stream-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	*p_len = 0;
+
+	result = wait_stream(p_stream, len < p_stream-> trigger ? len : p_stream-> trigger, wait);
+	if(SUCCESS != result && (NOT_WAIT != result || p_stream-> in == p_stream-> out)) {
+
+		return result;
+	}
+
+	avail = p_stream-> in - p_stream-> out;
+	if(len > avail) {
+
+		len = avail;
+	}
+
+	SMP_RMB();
+
+	pos = p_stream-> out & (p_stream-> size - 1);
+
+	first = p_stream-> size - pos;
+	if(first > len) {
+
+		first = len;
+	}
+
+	copy_item(p_data, p_stream-> p_buf + pos, first);
+	copy_item((u8*) p_data + first, p_stream-> p_buf, len - first);
+
+	*p_len = len;
+
+	SMP_MB();
+	p_stream-> out += len;
+
+	return SUCCESS;
+}
+
+// create message pool, p_mem holds MSG_POOL_SIZE(size, num) bytes
+
+STATUS create_msg_pool(MsgPool* p_pool, void* p_mem, u32 size, u32 num) {
+
+	MsgHead* p_head;
+	u32 stride;
+	u32 i;
+
+	if(NULL == p_pool || NULL == p_mem) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!size || !num) {
+
+		return PARAM_ERROR;
+	}
+
+	stride = MSG_POOL_SIZE(size, 1);
+
+	p_pool-> lock = 0;
+	p_pool-> free = NULL;
+	p_pool-> free_num = num;
+	p_pool-> size = size;
+
+	for(i = num; i > 0; i --) {
+
+		p_head = (MsgHead*) ((u8*) p_mem + (i - 1) * stride);
+		p_head-> pool = p_pool;
+		p_head-> ref = 0;
+		p_head-> next = (MsgHead*) p_pool-> free;
+		p_pool-> free = p_head;
+	}
+
+	return SUCCESS;
+}
+
+// take a block from the pool, the caller holds the only reference. may be
+// called from isr
+
+STATUS alloc_msg(MsgPool* p_pool, void** pp_msg) {
+
+	MsgHead* p_head;
+
+	if(NULL == p_pool || NULL == pp_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_pool);
+
+	p_head = (MsgHead*) p_pool-> free;
+	if(NULL == p_head) {
+
+		OBJ_UNLOCK(p_pool);
+		ENABLE_IE();
+
+		return POOL_EMPTY;
+	}
+
+	p_pool-> free = p_head-> next;
+	p_pool-> free_num --;
+
+	OBJ_UNLOCK(p_pool);
+	ENABLE_IE();
+
+	p_head-> ref = 1;
+	*pp_msg = (u8*) p_head + MSG_HEAD_SIZE;
+
+	return SUCCESS;
+}
+
+// drop one reference to a pool block, the last one puts it back
+
+STATUS release_msg(void* p_msg) {
+
+	MsgHead* p_head;
+	MsgPool* p_pool;
+	u32 ref;
+	u32 prev;
+
+	if(NULL == p_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	p_head = (MsgHead*) ((u8*) p_msg - MSG_HEAD_SIZE);
+
+	ref = p_head-> ref;
+
+	while(1) {
+
+		if(!ref) {
+
+			return PARAM_ERROR;
+		}
+
+		prev = ATOMIC_CAS(&p_head-> ref, ref, ref - 1);
+		if(prev == ref) {
+
+			break;
+		}
+
+		ref = prev;
+	}
+
+	if(1 != ref) {
+
+		return SUCCESS;
+	}
+
+	p_pool = p_head-> pool;
+
+	DISABLE_IE();
+	OBJ_LOCK(p_pool);
+
+	p_head-> next = (MsgHead*) p_pool-> free;
+	p_pool-> free = p_head;
+	p_pool-> free_num ++;
+
+	OBJ_UNLOCK(p_pool);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// add num references to a pool block, one per consumer it is passed on to
+
+static void hold_msg(void* p_msg, u32 num) {
+
+	MsgHead* p_head;
+	u32 ref;
+	u32 prev;
+
+	p_head = (MsgHead*) ((u8*) p_msg - MSG_HEAD_SIZE);
+
+	ref = p_head-> ref;
+
+	while((prev = ATOMIC_CAS(&p_head-> ref, ref, ref + num)) != ref) {
+
+		ref = prev;
+	}
+}
+
+// create topic
+
+STATUS create_topic(Topic* p_topic) {
+
+	if(NULL == p_topic) {
+
+		return PARAM_ERROR;
+	}
+
+	p_topic-> lock = 0;
+	list_init(&p_topic-> head);
+	p_topic-> sub_num = 0;
+
+	return SUCCESS;
+}
+
+// deliver the messages of a topic to a msg buffer, every message taken from
+// it must be handed to release_msg() once done with. MSG_FULL once the topic
+// has TOPIC_SUB_NUM subscribers
+
+STATUS subscribe_topic(Topic* p_topic, Subscriber* p_sub, Msgbuf* p_msg_buf) {
+
+	if(NULL == p_topic || NULL == p_sub || NULL == p_msg_buf) {
+
+		return PARAM_ERROR;
+	}
+
+	if(BUF_TYPE != p_msg_buf-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	p_sub-> p_msg_buf = p_msg_buf;
+	p_sub-> drop = 0;
+
+	DISABLE_IE();
+	OBJ_LOCK(p_topic);
+
+	if(TOPIC_SUB_NUM == p_topic-> sub_num) {
+
+		OBJ_UNLOCK(p_topic);
+		ENABLE_IE();
+
+		return MSG_FULL;
+	}
+
+	list_insert(&p_topic-> head, &p_sub-> node);
+	p_topic-> sub_num ++;
+
+	OBJ_UNLOCK(p_topic);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// stop a subscription, messages already queued stay in the msg buffer. a
+// publish_msg() that copied the subscribers out before may still deliver to
+// it, so the Subscriber and its msg buffer must outlive such a publish
+
+STATUS unsubscribe_topic(Topic* p_topic, Subscriber* p_sub) {
+
+	if(NULL == p_topic || NULL == p_sub) {
+
+		return PARAM_ERROR;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_topic);
+
+	list_delete(&p_sub-> node);
+	p_topic-> sub_num --;
+
+	OBJ_UNLOCK(p_topic);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// publish a pool block filled in place, every subscriber gets the same
+// block and one reference. the publisher's reference is dropped here, so
+// p_msg must not be touched afterwards. the subscribers are copied out
+// under the topic lock and served after it, so the lock is never held
+// while a msg buffer takes its own lock and wakes a receiver
+
+STATUS publish_msg(Topic* p_topic, void* p_msg) {
+
+	Subscriber* sub[TOPIC_SUB_NUM];
+	ListNode* p_node;
+	u32 num;
+	u32 drop;
+	u32 i;
+
+	if(NULL == p_topic || NULL == p_msg) {
+
+		return PARAM_ERROR;
+	}
+
+	num = 0;
+
+	DISABLE_IE();
+	OBJ_LOCK(p_topic);
+
+	for(p_node = p_topic-> head.next; p_node != &p_topic-> head; p_node = p_node-> next) {
+
+		sub[num ++] = get_list_entry(p_node, Subscriber, node);
+	}
+
+	OBJ_UNLOCK(p_topic);
+	ENABLE_IE();
+
+	// the references go first, a subscriber may release at once
+
+	hold_msg(p_msg, num);
+
+	for(i = 0; i < num; i ++) {
+
+		if(SUCCESS != put_msg_buf(sub[i]-> p_msg_buf, p_msg)) {
+
+			// publishers no longer share the topic lock here
+
+			drop = sub[i]-> drop;
+
+			while(ATOMIC_CAS(&sub[i]-> drop, drop, drop + 1) != drop) {
+
+				drop = sub[i]-> drop;
+			}
+
+			release_msg(p_msg);
+		}
+	}
+
+	return release_msg(p_msg);
+}
+
+
+// create event
+
+STATUS create_event(Event* p_event, u32 val){
+
+	if(NULL == p_event) {
+
+		return PARAM_ERROR;
+	}
+
+	p_event-> blk_type = EVENT_TYPE;
+	p_event-> lock = 0;
+	list_init(&p_event-> head);
+	list_init(&p_event-> sel);
+	p_event-> val = val;
+
+	return SUCCESS;
+}
+
+// get event
+
+STATUS get_event(Event* p_event, u32 option, u32 val, u32* p_data, u8 wait){
+
+	STATUS result;
+
+	if(is_in_irq()){
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_event) {
+
+		return PARAM_ERROR;
+	}
+
+	if(EVENT_TYPE != p_event-> blk_type){
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	if((AND_OPTION != option) && (OR_OPTION != option)){
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == p_data) {
+
+		return PARAM_ERROR;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_event);
+
+	if(AND_OPTION == option) {
+
+		if(val == (p_event-> val & val)) {
+
+			*p_data = val;
+			p_event-> val &= ~val;
+
+			OBJ_UNLOCK(p_event);
+			ENABLE_IE();
+
+			return SUCCESS;
+		}
+
+	}else {
+
+		if(p_event-> val & val) {
+
+			*p_data = p_event-> val & val;
+			p_event-> val &= ~(*p_data);
+
+			OBJ_UNLOCK(p_event);
+			ENABLE_IE();
+
+			return SUCCESS;
+		}
+	}
+
+	if(is_sched_lock()) {
+
+		OBJ_UNLOCK(p_event);
+		ENABLE_IE();
+
+		return OS_SCHED_LOCKED;
+	}
+
+	if(!wait) {
+
+		OBJ_UNLOCK(p_event);
+		ENABLE_IE();
+
+		return NOT_WAIT;
+	}
+
+	current_task-> event_opt = option;
+	current_task-> event_val = val;
+	result = block_cur_task(&p_event-> head, &p_event-> lock);
+
+	ENABLE_IE();
+
+	if(SUCCESS != result) {
+
+		return result;
+	}
+
+	DISABLE_IE();
+	*p_data = current_task-> event_data;
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// put event
+
+STATUS put_event(Event* p_event, u32 val) {
+
+	Task* p_task;
+	ListNode* p_node;
+
+	if(NULL == p_event) {
+
+		return PARAM_ERROR;
+	}
+
+	if(EVENT_TYPE != p_event-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_event);
+
+	p_event-> val |= val;
+
+	if(is_list_empty(&p_event->head)){
+
+		wake_sel_task(&p_event-> sel);
+
+		OBJ_UNLOCK(p_event);
+		ENABLE_IE();
+
+		return SUCCESS;
+	}
+
+	p_node = p_event->head.next;
+
+	while(p_node != &p_event->head) {
+
+		p_task = get_list_entry(p_node, Task, blk);
+
+		if(AND_OPTION == p_task-> event_opt) {
+
+			if(p_task-> event_val == (p_event-> val & p_task-> event_val)){
+
+				p_task-> event_data = p_task-> event_val;
+				p_event-> val &= ~p_task-> event_val;
+
+				p_node = p_node->next;
+
+				wake_blk_task(p_task);
+
+				continue;
+			}
+
+		}else {
+
+			if(p_event-> val & p_task-> event_val) {
+
+				p_task-> event_data = p_event-> val & p_task-> event_val;
+				p_event-> val &= ~p_task-> event_data;
+
+				p_node = p_node->next;
+
+				wake_blk_task(p_task);
+
+				continue;
+			}
+		}
+
+		p_node = p_node->next;
+	}
+
+	// bits nobody waited for may still interest a selecting task
+
+	wake_sel_task(&p_event-> sel);
+
+	OBJ_UNLOCK(p_event);
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// wait until any of num objects can be taken, up to timeout ticks, and
+// return its index. the object is only reported, the caller takes it with
+// the matching get_* and wait 0, which may still lose the race to another
+// task. sems, mailboxes, message buffers, priority message buffers and
+// events can be selected
+
+STATUS select_wait(SelectItem* p_item, u32 num, u32* p_index, u32 timeout) {
+
+	SelObj* p_obj;
+	STATUS result;
+	u32 count;
+	u32 index;
+	u32 i;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_item || !num || NULL == p_index) {
+
+		return PARAM_ERROR;
+	}
+
+	for(i = 0; i < num; i ++) {
+
+		if(NULL == p_item[i].obj) {
+
+			return PARAM_ERROR;
+		}
+
+		p_obj = (SelObj*) p_item[i].obj;
+
+		if(SEM_TYPE != p_obj-> blk_type && MAIL_TYPE != p_obj-> blk_type && BUF_TYPE != p_obj-> blk_type
+			&& PRIO_BUF_TYPE != p_obj-> blk_type && EVENT_TYPE != p_obj-> blk_type) {
+
+			return WRONG_BLOCK_TYPE;
+		}
+
+		p_item[i].task = current_task;
+		list_init(&p_item[i].node);
+	}
+
+	DISABLE_IE();
+
+	result = SUCCESS;
+
+	current_task-> wait_timeout = 0;
+
+	if(NO_WAIT != timeout && WAIT_FOREVER != timeout) {
+
+		current_task-> wait_timer.val = timeout;
+		activate_timer(&current_task-> wait_timer);
+	}
+
+	while(1) {
+
+		// set sel_wait first, a put between here and the block clears it
+
+		RDY_LOCK();
+		current_task-> sel_wait = 1;
+		current_task-> sel_item = p_item;
+		current_task-> sel_num = num;
+		RDY_UNLOCK();
+
+		// register on every object, unless one is ready already
+
+		index = num;
+
+		for(i = 0; i < num; i ++) {
+
+			p_obj = (SelObj*) p_item[i].obj;
+
+			OBJ_LOCK(p_obj);
+
+			if(SEM_TYPE == p_obj-> blk_type) {
+
+				// force put_sem onto the slow path, which wakes us
+
+				count = ((Sem*) p_obj)-> count;
+
+				while(!(count & ~HAS_WAITER) && ATOMIC_CAS(&((Sem*) p_obj)-> count, count, count | HAS_WAITER) != count) {
+
+					count = ((Sem*) p_obj)-> count;
+				}
+			}
+
+			if(is_item_ready(&p_item[i])) {
+
+				index = i;
+
+				OBJ_UNLOCK(p_obj);
+
+				break;
+			}
+
+			list_insert(&p_obj-> sel, &p_item[i].node);
+
+			OBJ_UNLOCK(p_obj);
+		}
+
+		if(num == index) {
+
+			if(NO_WAIT == timeout) {
+
+				result = NOT_WAIT;
+
+			}else if(is_sched_lock()) {
+
+				result = OS_SCHED_LOCKED;
+
+			}else {
+
+				RDY_LOCK();
+
+				// blocked on no object, a put on any of them or the timeout wakes us
+
+				if(current_task-> sel_wait && !current_task-> wait_timeout) {
+
+					list_init(&current_task-> blk);
+					current_task-> blk_lock = NULL;
+					current_task-> blk_ns = GET_NS();
+
+					remove_from_rdy_queue(current_task);
+					current_task-> state = BLOCKED;
+
+					result = dispatch();
+				}
+
+				RDY_UNLOCK();
+			}
+		}
+
+		RDY_LOCK();
+		current_task-> sel_wait = 0;
+		current_task-> sel_item = NULL;
+		RDY_UNLOCK();
+
+		index = remove_sel_item(p_item, num);
+
+		// another task may have taken the object first, then wait again
+
+		if(num != index || SUCCESS != result || current_task-> wait_timeout) {
+
+			break;
+		}
+	}
+
+	if(NO_WAIT != timeout && WAIT_FOREVER != timeout) {
+
+		deactivate_timer(&current_task-> wait_timer);
+	}
+
+	ENABLE_IE();
+
+	if(num != index) {
+
+		*p_index = index;
+
+		return SUCCESS;
+	}
+
+	if(SUCCESS == result) {
+
+		result = TIMEOUT;
+	}
+
+	return result;
+}
+
+// create channel
+
+STATUS create_channel(Channel* p_chan) {
+
+	if(NULL == p_chan) {
+
+		return PARAM_ERROR;
+	}
+
+	p_chan-> blk_type = CHAN_TYPE;
+	p_chan-> lock = 0;
+	list_init(&p_chan-> head);
+	list_init(&p_chan-> recv);
+	p_chan-> server = NULL;
 
 	return SUCCESS;
 }
 
-// get mutex
+// send a request and sleep until the server replies. a waiting server gets
+// the cpu straight away, and runs at the client priority until it replies
 
-STATUS get_mutex(Mutex* p_mutex, u8 wait) {
+STATUS send_channel(Channel* p_chan, void* msg, void** pp_reply) {
 
+	Task* p_server;
 	STATUS result;
 
 	if(is_in_irq()) {
@@ -480,730 +4968,1200 @@ STATUS get_mutex(Mutex* p_mutex, u8 wait) {
 		return IN_IRQ;
 	}
 
-	if(NULL == p_mutex) {
+	if(NULL == p_chan) {
 
 		return PARAM_ERROR;
 	}
 
-	if(MUT_TYPE != p_mutex-> blk_type) {
+	if(CHAN_TYPE != p_chan-> blk_type) {
 
 		return WRONG_BLOCK_TYPE;
 	}
 
+	if(is_sched_lock()) {
+
+		return OS_SCHED_LOCKED;
+	}
+
 	DISABLE_IE();
+	OBJ_LOCK(p_chan);
 
-	if(p_mutex-> count) {
+	current_task-> ipc_msg = msg;
+	current_task-> ipc_reply = NULL;
 
-		p_mutex-> count = 0;
-		p_mutex-> owner = current_task;
+	if(is_list_empty(&p_chan-> recv)) {
 
-		ENABLE_IE();
+		// no server waiting, queue up and lend our priority to the last one
 
-		return SUCCESS;
+		RDY_LOCK();
+
+		p_server = p_chan-> server;
+		if(NULL != p_server && current_task-> prio < p_server-> prio) {
+
+			change_task_prio(p_server, current_task-> prio);
+		}
+
+		RDY_UNLOCK();
+
+		current_task-> ipc_wait = 0;
+		result = block_cur_task(&p_chan-> head, &p_chan-> lock);
+
+	}else {
+
+		p_server = get_list_entry(p_chan-> recv.next, Task, blk);
+		remove_from_blk_queue(p_server);
+		p_server-> ipc_client = current_task;
+		current_task-> ipc_server = p_server;
+
+		// we now wait for the reply on no object
+
+		current_task-> ipc_wait = 1;
+		list_init(&current_task-> blk);
+		current_task-> blk_lock = NULL;
+		current_task-> blk_ns = GET_NS();
+
+		RDY_LOCK();
+
+		// lend our prio on top of the server's other boosts, worked out
+		// while the channel lock still guards its client list
+
+		p_server-> ipc_lent = current_task-> prio;
+		change_task_prio(p_server, boost_prio(p_server));
+
+		OBJ_UNLOCK(p_chan);
+
+		// the server takes our run queue slot and the cpu in one step
+
+		p_server-> wake_ns = current_task-> blk_ns;
+		p_server-> state = READY;
+		replace_in_rdy_queue(current_task, p_server);
+		current_task-> state = BLOCKED;
+
+		switch_to_task(p_server);
+		RDY_UNLOCK();
+
+		result = SUCCESS;
 	}
 
-	if(is_sched_lock()) {
+	if(NULL != pp_reply) {
+
+		*pp_reply = current_task-> ipc_reply;
+	}
+
+	ENABLE_IE();
+
+	return result;
+}
+
+// receive the next request, p_client is handed back to reply_channel().
+// the server runs at the client priority until it replies
+
+STATUS receive_channel(Channel* p_chan, void** pp_msg, Task** pp_client, u8 wait) {
+
+	Task* p_client;
+	STATUS result;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_chan || NULL == pp_msg || NULL == pp_client) {
+
+		return PARAM_ERROR;
+	}
+
+	if(CHAN_TYPE != p_chan-> blk_type) {
+
+		return WRONG_BLOCK_TYPE;
+	}
+
+	DISABLE_IE();
+	OBJ_LOCK(p_chan);
+
+	p_chan-> server = current_task;
+	current_task-> ipc_chan = p_chan;
+
+	if(is_list_empty(&p_chan-> head)) {
+
+		if(!wait) {
+
+			OBJ_UNLOCK(p_chan);
+			ENABLE_IE();
+
+			return NOT_WAIT;
+		}
+
+		if(is_sched_lock()) {
+
+			OBJ_UNLOCK(p_chan);
+			ENABLE_IE();
+
+			return OS_SCHED_LOCKED;
+		}
+
+		// a client hands itself over in send_channel()
+
+		current_task-> ipc_client = NULL;
+		result = block_cur_task(&p_chan-> recv, &p_chan-> lock);
+		if(SUCCESS != result) {
+
+			ENABLE_IE();
+
+			return result;
+		}
+
+		p_client = current_task-> ipc_client;
+
+	}else {
+
+		p_client = get_list_entry(p_chan-> head.next, Task, blk);
+		remove_from_blk_queue(p_client);
+
+		RDY_LOCK();
+
+		p_client-> ipc_wait = 1;
+		p_client-> ipc_server = current_task;
+		current_task-> ipc_lent = p_client-> prio;
+
+		if(p_client-> prio < current_task-> prio) {
+
+			change_task_prio(current_task, p_client-> prio);
+		}
+
+		RDY_UNLOCK();
+		OBJ_UNLOCK(p_chan);
+	}
+
+	*pp_msg = p_client-> ipc_msg;
+	*pp_client = p_client;
+
+	ENABLE_IE();
+
+	return SUCCESS;
+}
+
+// reply to a received client, only the server that received it may. the
+// server gives back the prio this client lent and keeps its other boosts,
+// the client gets the cpu straight away unless it ranks below us
+
+STATUS reply_channel(Task* p_client, void* reply) {
+
+	Channel* p_chan;
+	u8 prio;
+
+	if(is_in_irq()) {
+
+		return IN_IRQ;
+	}
+
+	if(NULL == p_client) {
+
+		return PARAM_ERROR;
+	}
+
+	p_chan = current_task-> ipc_chan;
+
+	DISABLE_IE();
+	if(NULL != p_chan) {
+
+		OBJ_LOCK(p_chan);
+	}
+
+	RDY_LOCK();
+
+	if(current_task != p_client-> ipc_server) {
+
+		RDY_UNLOCK();
+		if(NULL != p_chan) {
+
+			OBJ_UNLOCK(p_chan);
+		}
 
 		ENABLE_IE();
 
-		return OS_SCHED_LOCKED;
-	} 
+		return NOT_SERVER;
+	}
 
-	if(!wait) {
+	if(BLOCKED != p_client-> state || !p_client-> ipc_wait) {
+
+		RDY_UNLOCK();
+		if(NULL != p_chan) {
+
+			OBJ_UNLOCK(p_chan);
+		}
 
 		ENABLE_IE();
 
 		return NOT_WAIT;
 	}
 
-	remove_from_rdy_queue(current_task);
-	add_to_blk_queue(&p_mutex-> head, current_task);
+	p_client-> ipc_wait = 0;
+	p_client-> ipc_server = NULL;
+	p_client-> ipc_reply = reply;
+	p_client-> wake_ns = GET_NS();
 
-	current_task-> state = BLOCKED;
-	
-	result = dispatch();
+	add_to_rdy_queue(p_client);
+	p_client-> state = READY;
+
+	current_task-> ipc_client = NULL;
+	current_task-> ipc_lent = PRIO_NUM;
+
+	prio = boost_prio(current_task);
+	if(prio != current_task-> prio) {
+
+		change_task_prio(current_task, prio);
+	}
+
+	if(NULL != p_chan) {
+
+		OBJ_UNLOCK(p_chan);
+	}
+
+	if(!is_sched_lock() && p_client-> prio <= current_task-> prio) {
+
+		switch_to_task(p_client);
+	}
 
+	RDY_UNLOCK();
 	ENABLE_IE();
 
-	return result;
+	return SUCCESS;
 }
 
-// put mutex
+// the tick isr reads g_timer_due, which is too wide to store atomically
 
-STATUS put_mutex(Mutex* p_mutex) {
+static void set_timer_due(u64 due) {
 
-	Task* p_task;
+	DISABLE_IE();
+	g_timer_due = due;
+	ENABLE_IE();
+}
+
+// find the earliest second + slack, caller holds the timer lock. the list is
+// sorted by second, so the walk stops once second passes the best so far
+
+static void update_timer_due() {
+
+	ListNode* p_node;
+	Timer* p_timer;
+	u64 due;
+
+	due = TIMER_IDLE;
+	p_node = g_timer.next;
+
+	while(p_node != &g_timer) {
+
+		p_timer = get_list_entry(p_node, Timer, list);
+		if(p_timer-> second >= due) {
+
+			break;
+		}
+
+		if(p_timer-> second + p_timer-> slack < due) {
+
+			due = p_timer-> second + p_timer-> slack;
+		}
+
+		p_node = p_node->next;
+	}
+
+	set_timer_due(due);
+}
+
+// sorted insert into a timer list, walking from p_node onwards
+
+static void insert_timer(ListNode* head, ListNode* p_node, Timer* p_timer) {
+
+	while(p_node != head) {
+
+		if(get_list_entry(p_node, Timer, list)-> second > p_timer-> second){
+
+			break;
+		}
+
+		p_node = p_node->next;
+	}
+
+	list_insert(p_node, &p_timer-> list);
+}
+
+// run a callback and keep track of the slowest run
+
+static void run_timer_func(Timer* p_timer) {
+
+	u64 start;
+	u64 cost;
+
+	start = GET_NS();
+
+	p_timer->func(p_timer-> param);
+
+	cost = GET_NS() - start;
+
+	if(cost > p_timer-> exec_max) {
+
+		p_timer-> exec_max = cost;
+	}
+}
+
+// round nanoseconds up to whole ticks, at least one
+
+static u32 ns_to_tick(u64 ns) {
+
+	u64 tick;
+
+	tick = (ns + TICK_NS() - 1) / TICK_NS();
+
+	if(!tick) {
+
+		tick = 1;
+	}
+
+	return (u32) tick;
+}
+
+// create timer
+
+STATUS create_timer(Timer* p_timer, u32 val, void(*func)(void*), void* param){
+
+	if(NULL == p_timer) {
+
+		return PARAM_ERROR;
+	}
+
+	if(!val) {
+
+		return PARAM_ERROR;
+	}
+
+	if(NULL == func) {
+
+		return PARAM_ERROR;
+	}
+
+	list_init(&p_timer-> list);
+	list_init(&p_timer-> run);
+	p_timer-> val = val;
+	p_timer-> period = 0;
+	p_timer-> func = func;
+	p_timer-> param = param;
+
+	p_timer-> slack = 0;
+	p_timer-> hard = 0;
+	p_timer-> service = NULL;
+
+	p_timer-> overrun = 0;
+	p_timer-> max_late = 0;
+	p_timer-> exec_max = 0;
+
+	return SUCCESS;
+}
+
+// allow the timer to fire up to slack ticks late, so it can share a timer
+// task wakeup with its neighbours
+
+STATUS set_timer_slack(Timer* p_timer, u32 slack){
+
+	if(NULL == p_timer) {
+
+		return PARAM_ERROR;
+	}
+
+	sched_lock();
+	SPIN_LOCK(&g_timer_lock);
+
+	p_timer-> slack = slack;
+
+	if(!p_timer-> hard && !is_list_empty(&p_timer-> list)) {
+
+		update_timer_due();
+	}
+
+	SPIN_UNLOCK(&g_timer_lock);
+	sched_unlock();
+
+	return SUCCESS;
+}
+
+// run the callback of an idle timer from timer_isr_func, hard timer callbacks
+// may only use what is allowed in an isr, such as put_* and post_defer
+
+STATUS set_timer_hard(Timer* p_timer, u8 hard){
 
-	if(NULL == p_mutex) {
+	if(NULL == p_timer) {
 
 		return PARAM_ERROR;
 	}
 
-	if(MUT_TYPE != p_mutex-> blk_type) {
+	if(!is_list_empty(&p_timer-> list) || NULL != p_timer-> service) {
 
-		return WRONG_BLOCK_TYPE;
+		return TIMER_TYPE_ERR;
 	}
 
-	DISABLE_IE();
+	p_timer-> hard = hard;
 
-	if(current_task != p_mutex-> owner) {
+	return SUCCESS;
+}
 
-		ENABLE_IE();
+// run the callback of an idle timer in a timer service task instead of the
+// kernel timer task, NULL goes back to the timer task
 
-		return NOT_MUTEX_OWNER;
-	}
+STATUS set_timer_service(Timer* p_timer, TimerService* p_service){
 
-	if(is_list_empty(&p_mutex->head)) {
+	if(NULL == p_timer) {
 
-		p_mutex-> count = 1;
-		p_mutex-> owner = NULL;
+		return PARAM_ERROR;
+	}
 
-		ENABLE_IE();
+	if(!is_list_empty(&p_timer-> list) || !is_list_empty(&p_timer-> run) || p_timer-> hard) {
 
-		return SUCCESS;
+		return TIMER_TYPE_ERR;
 	}
 
-	p_task = get_list_entry(p_mutex->head.next, Task, blk);
-
-	remove_from_blk_queue(p_task);
-	add_to_rdy_queue(p_task);
+	p_timer-> service = p_service;
 
-	p_mutex-> owner = p_task;
+	return SUCCESS;
+}
 
-	p_task-> state = READY;
+// create timer armed in nanoseconds, rounded up to the tick
 
-	ENABLE_IE();
+STATUS create_timer_ns(Timer* p_timer, u64 ns, void(*func)(void*), void* param){
 
-	return SUCCESS;	
+	return create_timer(p_timer, ns_to_tick(ns), func, param);
 }
 
-// create mail
+// create periodic timer, first expiry after val ticks and then every period
+// ticks counted from the previous deadline, so callback latency never drifts
 
-STATUS create_mail(Mailbox* p_box, void* msg) {
+STATUS create_periodic_timer(Timer* p_timer, u32 val, u32 period, void(*func)(void*), void* param){
 
-	if(NULL == p_box) {
+	STATUS result;
+
+	if(!period) {
 
 		return PARAM_ERROR;
 	}
 
-	p_box-> blk_type = MAIL_TYPE;
-	list_init(&p_box-> head);
-	p_box-> msg = msg;
+	result = create_timer(p_timer, val, func, param);
+	if(SUCCESS != result) {
+
+		return result;
+	}
+
+	p_timer-> period = period;
 
 	return SUCCESS;
 }
 
+// create periodic timer in nanoseconds, both values rounded up to the tick
 
-// get mail
+STATUS create_periodic_timer_ns(Timer* p_timer, u64 ns, u64 period_ns, void(*func)(void*), void* param){
 
-STATUS get_mail(Mailbox* p_box, void** pp_msg, u8 wait) {
+	return create_periodic_timer(p_timer, ns_to_tick(ns), ns_to_tick(period_ns), func, param);
+}
 
-	STATUS result;
+// activate timer
+
+STATUS activate_timer(Timer* p_timer) {
 
 	if(is_in_irq()) {
 
 		return IN_IRQ;
 	}
 
-	if(NULL == p_box) {
+	if(NULL == p_timer) {
 
 		return PARAM_ERROR;
 	}
 
-	if(NULL == pp_msg) {
+	// hard timers are owned by the tick isr
 
-		return PARAM_ERROR;
-	}
+	if(p_timer-> hard) {
 
-	if(MAIL_TYPE != p_box-> blk_type) {
+		DISABLE_IE();
+		SPIN_LOCK(&g_hard_timer_lock);
 
-		return WRONG_BLOCK_TYPE;
-	}
+		if(!is_list_empty(&p_timer-> list)) {
 
-	DISABLE_IE();
-	if(p_box-> msg) {
+			list_delete(&p_timer-> list);
+		}
 
-		*pp_msg = p_box-> msg;
-		p_box-> msg = NULL;
+		p_timer-> second = g_tick + p_timer-> val;
+		insert_timer(&g_hard_timer, g_hard_timer.next, p_timer);
+
+		SPIN_UNLOCK(&g_hard_timer_lock);
 		ENABLE_IE();
 
 		return SUCCESS;
 	}
 
-	if(is_sched_lock()) {
-
-		ENABLE_IE();
-
-		return OS_SCHED_LOCKED;
-	}
+	sched_lock();
+	SPIN_LOCK(&g_timer_lock);
 
-	if(!wait) {
+	// activating a running timer restarts it
 
-		ENABLE_IE();
+	if(!is_list_empty(&p_timer-> list)) {
 
-		return NOT_WAIT;
+		list_delete(&p_timer-> list);
 	}
 
-	remove_from_rdy_queue(current_task);
-	add_to_blk_queue(&p_box-> head, current_task);
-
-	current_task-> state = BLOCKED;
-	result = dispatch();
-	ENABLE_IE();
+	p_timer-> second = g_tick + p_timer-> val;
+	insert_timer(&g_timer, g_timer.next, p_timer);
 
-	if(SUCCESS != result) {
+	if(p_timer-> second + p_timer-> slack < g_timer_due) {
 
-		return result;
+		set_timer_due(p_timer-> second + p_timer-> slack);
 	}
 
-	DISABLE_IE();
-
-	*pp_msg = current_task-> msg;
-
-	ENABLE_IE();
+	SPIN_UNLOCK(&g_timer_lock);
+	sched_unlock();
 
 	return SUCCESS;
-}
 
+}
 
-// put mail
+// deactivate timer, also drops a callback still waiting in a service task
 
-STATUS put_mail(Mailbox* p_box, void* msg) {
+STATUS deactivate_timer(Timer* p_timer){
 
-	Task* p_task;
+	STATUS result;
 
-	if(NULL == p_box) {
+	if(is_in_irq()) {
 
-		return PARAM_ERROR;
+		return IN_IRQ;
 	}
 
-	if(NULL == msg) {
+	if(NULL == p_timer) {
 
 		return PARAM_ERROR;
 	}
 
-	if(MAIL_TYPE != p_box-> blk_type) {
-
-		return WRONG_BLOCK_TYPE;
-	}
+	if(p_timer-> hard) {
 
-	DISABLE_IE();
+		result = TIMER_NOT_RUN;
 
-	if(p_box-> msg) {
+		DISABLE_IE();
+		SPIN_LOCK(&g_hard_timer_lock);
 
-		ENABLE_IE();
+		if(!is_list_empty(&p_timer-> list)) {
 
-		return MSG_EXIST;
-	}
+			list_delete(&p_timer-> list);
+			list_init(&p_timer-> list);
 
-	if(is_list_empty(&p_box->head)){
+			result = SUCCESS;
+		}
 
-		p_box->msg = msg;
+		SPIN_UNLOCK(&g_hard_timer_lock);
 		ENABLE_IE();
 
-		return SUCCESS;
+		return result;
 	}
 
-	p_task = get_list_entry(p_box->head.next, Task, blk);
-
-	remove_from_blk_queue(p_task);
-	add_to_rdy_queue(p_task);
-
-	p_task-> msg = msg;
+	result = TIMER_NOT_RUN;
 
-	p_task-> state = READY;
+	sched_lock();
+	SPIN_LOCK(&g_timer_lock);
 
-	ENABLE_IE();
+	// g_timer_due may now be early, which only costs one empty wakeup
 
-	return SUCCESS;
-}
+	if(!is_list_empty(&p_timer-> list)){
 
-// create message buffer
+		list_delete(&p_timer-> list);
+		list_init(&p_timer-> list);
 
-STATUS create_msg_buf(Msgbuf* p_msg_buf, void** pp_msg, u32 size) {
+		result = SUCCESS;
+	}
 
-	if(NULL == p_msg_buf) {
+	if(NULL != p_timer-> service) {
 
-		return PARAM_ERROR;
-	}
+		SPIN_LOCK(&p_timer-> service-> lock);
 
-	if(NULL == pp_msg) {
+		if(!is_list_empty(&p_timer-> run)) {
 
-		return PARAM_ERROR;
-	}
+			list_delete(&p_timer-> run);
+			list_init(&p_timer-> run);
 
-	if(!size) {
+			result = SUCCESS;
+		}
 
-		return PARAM_ERROR;
+		SPIN_UNLOCK(&p_timer-> service-> lock);
 	}
 
-	p_msg_buf-> blk_type = BUF_TYPE;
-	list_init(&p_msg_buf->head);
-	p_msg_buf-> pp_msg = pp_msg;
-	p_msg_buf-> size = size;
+	SPIN_UNLOCK(&g_timer_lock);
+	sched_unlock();
 
-	p_msg_buf-> count = 0;
-	p_msg_buf-> start = 0;
-	p_msg_buf-> end   = 0;
+	return result;
 
-	return SUCCESS;
 }
 
-// get message from buffer
+// move a fired periodic timer to its next deadline. deadlines already
+// missed are skipped and counted as overruns
 
-STATUS get_msg_buf(Msgbuf* p_msg_buf, void** pp_msg, u8 wait) {
+static void rearm_timer(ListNode* head, Timer* p_timer) {
 
-	STATUS result;
+	ListNode* p_node;
+	u32 missed;
 
-	if(is_in_irq()) {
+	p_timer-> second += p_timer-> period;
 
-		return IN_IRQ;
-	}
+	if(p_timer-> second <= g_tick) {
 
-	if(NULL == p_msg_buf) {
+		missed = (u32) ((g_tick - p_timer-> second) / p_timer-> period) + 1;
 
-		return PARAM_ERROR;
+		p_timer-> overrun += missed;
+		p_timer-> second += (u64) missed * p_timer-> period;
 	}
 
-	if(NULL == pp_msg){
+	// stay in place while still ahead of the next timer, otherwise only
+	// walk the part of the list behind the old position
 
-		return PARAM_ERROR;
-	}
+	p_node = p_timer-> list.next;
 
-	if(BUF_TYPE != p_msg_buf-> blk_type){
+	if(p_node == head || get_list_entry(p_node, Timer, list)-> second > p_timer-> second) {
 
-		return WRONG_BLOCK_TYPE;
+		return;
 	}
 
-	DISABLE_IE();
+	list_delete(&p_timer-> list);
+	insert_timer(head, p_node, p_timer);
+}
 
-	if(p_msg_buf-> count) {
+// take a due timer off its list, or rearm it when periodic
 
-		*pp_msg = p_msg_buf->pp_msg[p_msg_buf-> end];
+static void expire_timer(ListNode* head, Timer* p_timer) {
 
-		p_msg_buf-> end ++;
+	if(g_tick - p_timer-> second > p_timer-> max_late) {
 
-		if(p_msg_buf-> end == p_msg_buf-> size){
+		p_timer-> max_late = (u32) (g_tick - p_timer-> second);
+	}
 
-			p_msg_buf-> end = 0;
-		}
+	if(p_timer-> period) {
 
-		p_msg_buf-> count --;
+		rearm_timer(head, p_timer);
 
-		ENABLE_IE();
+	}else {
 
-		return SUCCESS;
+		list_delete(&p_timer-> list);
+		list_init(&p_timer-> list);
 	}
+}
 
-	if(is_sched_lock()) {
-
-		ENABLE_IE();
+// hand a due timer to its service task, caller holds the timer lock. a
+// callback still waiting from the previous expiry counts as an overrun
 
-		return OS_SCHED_LOCKED;
-	}
+static void queue_timer_service(Timer* p_timer) {
 
-	if(!wait) {
+	TimerService* p_service;
+	u32 was_empty;
 
-		ENABLE_IE();
+	p_service = p_timer-> service;
 
-		return NOT_WAIT;
-	}
+	SPIN_LOCK(&p_service-> lock);
 
-	remove_from_rdy_queue(current_task);
-	add_to_blk_queue(&p_msg_buf-> head, current_task);
+	if(!is_list_empty(&p_timer-> run)) {
 
-	current_task-> state = BLOCKED;
-	result = dispatch();
-	ENABLE_IE();
+		p_timer-> overrun ++;
 
-	if(SUCCESS != result) {
+		SPIN_UNLOCK(&p_service-> lock);
 
-		return result;
+		return;
 	}
 
-	DISABLE_IE();
-	*pp_msg = current_task-> buf_msg;
-	ENABLE_IE();
+	was_empty = is_list_empty(&p_service-> head);
+	list_insert(&p_service-> head, &p_timer-> run);
 
-	return SUCCESS;
+	SPIN_UNLOCK(&p_service-> lock);
+
+	if(was_empty) {
+
+		put_sem(&p_service-> sem);
+	}
 }
 
-// put message buffer
+// timer task function
 
-STATUS put_msg_buf(Msgbuf* p_msg_buf, void* p_msg){
+static void timer_running_func(void* param) {
 
-	Task* p_task;
+	Timer* p_timer;
 
-	if(NULL == p_msg_buf){
+	param = param;
 
-		return PARAM_ERROR;
-	}
+	while(1) {
 
-	if(NULL == p_msg) {
+		get_sem(&timer_sem, 1);
 
-		return PARAM_ERROR;
-	}
+		sched_lock();
+		SPIN_LOCK(&g_timer_lock);
 
-	if(BUF_TYPE != p_msg_buf-> blk_type){
+		// let the tick isr signal again for timers falling due from now on
 
-		return WRONG_BLOCK_TYPE;
-	}
+		g_timer_wake = 0;
+		g_timer_wakeup ++;
 
-	DISABLE_IE();
+		while(!is_list_empty(&g_timer)) {
 
-	if(is_list_empty(&p_msg_buf-> head)){
+			p_timer = get_list_entry(g_timer.next, Timer, list);
+			if(p_timer-> second > g_tick){
+				break;
+			}
 
-		if(p_msg_buf-> size == p_msg_buf-> count){
+			expire_timer(&g_timer, p_timer);
 
-			ENABLE_IE();
+			if(NULL != p_timer-> service) {
 
-			return MSG_FULL;
-		}
+				queue_timer_service(p_timer);
 
-		p_msg_buf-> pp_msg[p_msg_buf-> start] = p_msg;
+				continue;
+			}
 
-		p_msg_buf-> start ++;
+			// callbacks may rearm timers or block, so never run them under
+			// the timer lock or with the scheduler locked
 
-		if(p_msg_buf-> start == p_msg_buf-> size) {
+			SPIN_UNLOCK(&g_timer_lock);
+			sched_unlock();
 
-			p_msg_buf-> start = 0;
-		}
+			run_timer_func(p_timer);
 
-		p_msg_buf-> count ++;
+			sched_lock();
+			SPIN_LOCK(&g_timer_lock);
+		}
 
-		ENABLE_IE();
+		update_timer_due();
 
-		return SUCCESS;
+		SPIN_UNLOCK(&g_timer_lock);
+		sched_unlock();
 	}
+}
 
-	p_task = get_list_entry(p_msg_buf->head.next, Task, blk);
+// timer service task function, runs the callbacks queued by the timer task
 
-	remove_from_blk_queue(p_task);
-	add_to_rdy_queue(p_task);
+static void timer_service_func(void* param) {
 
-	p_task-> buf_msg = p_msg;
+	TimerService* p_service;
+	Timer* p_timer;
 
-	p_task-> state = READY;
+	p_service = (TimerService*) param;
 
-	ENABLE_IE();
+	while(1) {
 
-	return SUCCESS;
-}
+		get_sem(&p_service-> sem, 1);
 
+		SPIN_LOCK(&p_service-> lock);
 
-// create event
+		while(!is_list_empty(&p_service-> head)) {
 
-STATUS create_event(Event* p_event, u32 val){
+			p_timer = get_list_entry(p_service-> head.next, Timer, run);
 
-	if(NULL == p_event) {
+			list_delete(&p_timer-> run);
+			list_init(&p_timer-> run);
 
-		return PARAM_ERROR;
-	}
+			SPIN_UNLOCK(&p_service-> lock);
 
-	p_event-> blk_type = EVENT_TYPE;
-	list_init(&p_event-> head);
-	p_event-> val = val;
+			run_timer_func(p_timer);
 
-	return SUCCESS;
+			SPIN_LOCK(&p_service-> lock);
+		}
+
+		SPIN_UNLOCK(&p_service-> lock);
+	}
 }
 
-// get event
+// create timer service task, one per callback priority
 
-STATUS get_event(Event* p_event, u32 option, u32 val, u32* p_data, u8 wait){
+STATUS create_timer_service(TimerService* p_service, u8 prio, void* p_stack, u32 stack_size){
 
 	STATUS result;
 
-	if(is_in_irq()){
+	if(NULL == p_service) {
 
-		return IN_IRQ;
+		return PARAM_ERROR;
 	}
 
-	if(NULL == p_event) {
+	if(prio >= PRIO_NUM) {
 
 		return PARAM_ERROR;
 	}
 
-	if(EVENT_TYPE != p_event-> blk_type){
+	p_service-> lock = 0;
+	list_init(&p_service-> head);
+	create_sem(&p_service-> sem, 0);
 
-		return WRONG_BLOCK_TYPE;
+	result = create_task(&p_service-> task, timer_service_func, p_service, p_stack, stack_size);
+	if(SUCCESS != result) {
+
+		return result;
 	}
 
-	if((AND_OPTION != option) && (OR_OPTION != option)){
+	return set_task_prio(&p_service-> task, prio);
+}
 
-		return PARAM_ERROR;
-	}
+// create work queue, buf holds size items. the workers come with add_worker
 
-	if(NULL == p_data) {
+STATUS create_workqueue(Workqueue* p_wq, WorkItem* p_buf, u32 size, u32 batch){
+
+	if(NULL == p_wq || NULL == p_buf || !size) {
 
 		return PARAM_ERROR;
 	}
 
-	DISABLE_IE();
+	if(!batch || batch > WORK_BATCH) {
 
-	if(AND_OPTION == option) {
+		return PARAM_ERROR;
+	}
 
-		if(val == (p_event-> val & val)) {
+	p_wq-> lock = 0;
+	p_wq-> p_buf = p_buf;
+	p_wq-> size = size;
+	p_wq-> start = 0;
+	p_wq-> count = 0;
+	p_wq-> batch = batch;
+	create_sem(&p_wq-> sem, 0);
+	p_wq-> idle = 0;
+	p_wq-> workers = 0;
+
+	p_wq-> depth_max = 0;
+	p_wq-> full = 0;
+	p_wq-> done = 0;
+	p_wq-> wakeups = 0;
+	p_wq-> latency_sum = 0;
+	p_wq-> latency_max = 0;
 
-			*p_data = val;
-			p_event-> val &= ~val;
+	return SUCCESS;
+}
 
-			ENABLE_IE();
+// submit func(param) to a work queue, from task or isr. an idle worker is
+// only woken for the first item of each batch, the items in between wait
+// for a worker that is awake already
 
-			return SUCCESS;
-		}
+STATUS submit_work(Workqueue* p_wq, void (*func)(void*), void* param){
 
-	}else {
+	WorkItem* p_item;
+	u32 wake;
 
-		if(p_event-> val & val) {
+	if(NULL == p_wq || NULL == func) {
 
-			*p_data = p_event-> val & val;
-			p_event-> val &= ~(*p_data);
+		return PARAM_ERROR;
+	}
 
-			ENABLE_IE();
+	DISABLE_IE();
+	SPIN_LOCK(&p_wq-> lock);
 
-			return SUCCESS;
-		}
-	}
+	if(p_wq-> count == p_wq-> size) {
 
-	if(is_sched_lock()) {
+		p_wq-> full ++;
 
+		SPIN_UNLOCK(&p_wq-> lock);
 		ENABLE_IE();
 
-		return OS_SCHED_LOCKED;
+		return MSG_FULL;
 	}
 
-	if(!wait) {
+	p_item = &p_wq-> p_buf[(p_wq-> start + p_wq-> count) % p_wq-> size];
+	p_item-> func = func;
+	p_item-> param = param;
+	p_item-> submit_ns = GET_NS();
 
-		ENABLE_IE();
+	p_wq-> count ++;
 
-		return NOT_WAIT;
+	if(p_wq-> count > p_wq-> depth_max) {
+
+		p_wq-> depth_max = p_wq-> count;
 	}
 
-	remove_from_rdy_queue(current_task);
-	add_to_blk_queue(&p_event-> head, current_task);
+	wake = 0;
 
-	current_task-> event_opt = option;
-	current_task-> event_val = val;
-	current_task-> state = BLOCKED;
+	if(p_wq-> idle && !((p_wq-> count - 1) % p_wq-> batch)) {
 
-	result = dispatch();
+		p_wq-> idle --;
+		wake = 1;
+	}
+
+	SPIN_UNLOCK(&p_wq-> lock);
 	ENABLE_IE();
 
-	if(SUCCESS != result) {
+	if(wake) {
 
-		return result;
+		put_sem(&p_wq-> sem);
 	}
 
-	DISABLE_IE();
-	*p_data = current_task-> event_data;
-	ENABLE_IE();
-
 	return SUCCESS;
 }
 
-// put event
+// worker task function, takes up to batch items at a time and runs them
+// outside the lock, sleeps once the queue is empty
 
-STATUS put_event(Event* p_event, u32 val) {
+static void work_running_func(void* param) {
 
-	Task* p_task;
-	ListNode* p_node;
+	Workqueue* p_wq;
+	WorkItem item[WORK_BATCH];
+	WorkItem* p_item;
+	u64 now;
+	u64 latency;
+	u32 num;
+	u32 i;
 
-	if(NULL == p_event) {
+	p_wq = (Workqueue*) param;
 
-		return PARAM_ERROR;
-	}
+	while(1) {
 
-	if(EVENT_TYPE != p_event-> blk_type) {
+		DISABLE_IE();
+		SPIN_LOCK(&p_wq-> lock);
 
-		return WRONG_BLOCK_TYPE;
-	}
+		if(!p_wq-> count) {
 
-	DISABLE_IE();
+			p_wq-> idle ++;
 
-	p_event-> val |= val;
+			SPIN_UNLOCK(&p_wq-> lock);
+			ENABLE_IE();
 
-	if(is_list_empty(&p_event->head)){
+			get_sem(&p_wq-> sem, 1);
 
-		ENABLE_IE();
+			DISABLE_IE();
+			SPIN_LOCK(&p_wq-> lock);
+			p_wq-> wakeups ++;
+			SPIN_UNLOCK(&p_wq-> lock);
+			ENABLE_IE();
 
-		return SUCCESS;
-	}
+			continue;
+		}
 
-	p_node = p_event->head.next;
+		now = GET_NS();
 
-	while(p_node != &p_event->head) {
+		for(num = 0; num < p_wq-> batch && p_wq-> count; num ++) {
 
-		p_task = get_list_entry(p_node, Task, blk);
+			p_item = &p_wq-> p_buf[p_wq-> start];
+			item[num] = *p_item;
 
-		if(AND_OPTION == p_task-> event_opt) {
+			p_wq-> start = (p_wq-> start + 1) % p_wq-> size;
+			p_wq-> count --;
 
-			if(p_task-> event_val == (p_event-> val & p_task-> event_val)){
+			latency = now - p_item-> submit_ns;
+			p_wq-> latency_sum += latency;
 
-				p_task-> event_data = p_task-> event_val;
-				p_event-> val &= ~p_task-> event_val;
+			if(latency > p_wq-> latency_max) {
 
-				p_node = p_node->next;
+				p_wq-> latency_max = latency;
+			}
+		}
 
-				remove_from_blk_queue(p_task);
-				add_to_rdy_queue(p_task);
+		p_wq-> done += num;
 
-				p_task-> state = READY;
+		SPIN_UNLOCK(&p_wq-> lock);
+		ENABLE_IE();
 
-				continue;
-			}
+		for(i = 0; i < num; i ++) {
 
-		}else {
+			item[i].func(item[i].param);
+		}
+	}
+}
 
-			if(p_event-> val & p_task-> event_val) {
+// add a worker task to a work queue, call it once per worker of the pool
 
-				p_task-> event_data = p_event-> val & p_task-> event_val;
-				p_event-> val &= ~p_task-> event_data;
+STATUS add_worker(Workqueue* p_wq, Task* p_task, u8 prio, void* p_stack, u32 stack_size){
 
-				p_node = p_node->next;
+	STATUS result;
 
-				remove_from_blk_queue(p_task);
-				add_to_rdy_queue(p_task);
+	if(NULL == p_wq || NULL == p_task) {
 
-				p_task-> state = READY;
+		return PARAM_ERROR;
+	}
 
-				continue;
-			}
-		}
+	if(prio >= PRIO_NUM) {
 
-		p_node = p_node->next;
+		return PARAM_ERROR;
 	}
 
+	result = create_task(p_task, work_running_func, p_wq, p_stack, stack_size);
+	if(SUCCESS != result) {
+
+		return result;
+	}
+
+	DISABLE_IE();
+	SPIN_LOCK(&p_wq-> lock);
+	p_wq-> workers ++;
+	SPIN_UNLOCK(&p_wq-> lock);
 	ENABLE_IE();
 
-	return SUCCESS;
+	return set_task_prio(p_task, prio);
 }
 
-// create timer
+// timer of a delayed work, hands the work over to its queue
 
-STATUS create_timer(Timer* p_timer, u32 val, void(*func)(void*), void* param){
+static void delayed_work_func(void* param) {
 
-	if(NULL == p_timer) {
+	DelayedWork* p_work;
 
-		return PARAM_ERROR;
-	}
+	p_work = (DelayedWork*) param;
 
-	if(!val) {
+	submit_work(p_work-> p_wq, p_work-> func, p_work-> param);
+}
 
-		return PARAM_ERROR;
-	}
+// create delayed work, submitting func(param) to p_wq once its delay is up
 
-	if(NULL == func) {
+STATUS create_delayed_work(DelayedWork* p_work, Workqueue* p_wq, void (*func)(void*), void* param){
+
+	if(NULL == p_work || NULL == p_wq || NULL == func) {
 
 		return PARAM_ERROR;
 	}
 
-	list_init(&p_timer-> list);
-	p_timer-> val = val;
-	p_timer-> func = func;
-	p_timer-> param = param;
+	p_work-> p_wq = p_wq;
+	p_work-> func = func;
+	p_work-> param = param;
 
-	return SUCCESS;
+	return create_timer(&p_work-> timer, 1, delayed_work_func, p_work);
 }
 
-// activate timer
-
-STATUS activate_timer(Timer* p_timer) {
+// submit a delayed work after delay ticks, a pending one starts over
 
-	ListNode* p_node;
+STATUS submit_delayed_work(DelayedWork* p_work, u32 delay){
 
-	if(is_in_irq()) {
+	if(NULL == p_work || !delay) {
 
-		return IN_IRQ;
+		return PARAM_ERROR;
 	}
 
-	if(NULL == p_timer) {
+	p_work-> timer.val = delay;
+
+	return activate_timer(&p_work-> timer);
+}
+
+// cancel a delayed work that did not reach its queue yet
+
+STATUS cancel_delayed_work(DelayedWork* p_work) {
+
+	if(NULL == p_work) {
 
 		return PARAM_ERROR;
 	}
 
-	sched_lock();
+	return deactivate_timer(&p_work-> timer);
+}
 
-	p_node = g_timer.next;
-	p_timer-> second = g_tick + p_timer-> val;
+// read the statistics of a work queue in one go, reset clears the maxima
+// and counters after reading
 
-	while(p_node != &g_timer) {
+STATUS get_workqueue_stat(Workqueue* p_wq, WorkStat* p_stat, u8 reset){
 
-		if(get_list_entry(p_node, Timer, list)-> second > p_timer-> second){
+	if(NULL == p_wq || NULL == p_stat) {
 
-			break;
-		}
+		return PARAM_ERROR;
+	}
 
-		p_node = p_node->next;
+	DISABLE_IE();
+	SPIN_LOCK(&p_wq-> lock);
+
+	p_stat-> depth = p_wq-> count;
+	p_stat-> depth_max = p_wq-> depth_max;
+	p_stat-> full = p_wq-> full;
+	p_stat-> done = p_wq-> done;
+	p_stat-> wakeups = p_wq-> wakeups;
+	p_stat-> latency_avg = p_wq-> done ? p_wq-> latency_sum / p_wq-> done : 0;
+	p_stat-> latency_max = p_wq-> latency_max;
+
+	if(reset) {
+
+		p_wq-> depth_max = p_wq-> count;
+		p_wq-> full = 0;
+		p_wq-> done = 0;
+		p_wq-> wakeups = 0;
+		p_wq-> latency_sum = 0;
+		p_wq-> latency_max = 0;
 	}
 
-	list_insert(p_node, &p_timer-> list);
-	sched_unlock();
+	SPIN_UNLOCK(&p_wq-> lock);
+	ENABLE_IE();
 
 	return SUCCESS;
-
 }
 
-// deactivate timer
+// post work from isr to the defer task, func(param) runs later in task
+// context together with everything else queued meanwhile
 
-STATUS deactivate_timer(Timer* p_timer){
-
-	if(is_in_irq()) {
+STATUS post_defer(void (*func)(void*), void* param) {
 
-		return IN_IRQ;
-	}
+	Defer* p_defer;
+	u32 head;
 
-	if(NULL == p_timer) {
+	if(NULL == func) {
 
 		return PARAM_ERROR;
 	}
 
-	sched_lock();
+	do {
 
-	if(is_list_empty(&p_timer-> list)){
+		head = g_defer_head;
 
-		sched_unlock();
+		if(head - g_defer_tail == DEFER_NUM) {
 
-		return TIMER_NOT_RUN;
-	}
+			return MSG_FULL;
+		}
 
-	list_delete(&p_timer-> list);
+	}while(ATOMIC_CAS(&g_defer_head, head, head + 1) != head);
 
-	sched_unlock();
+	// func is written last, the defer task takes a slot once func is set,
+	// so param must be visible before func
 
-	return SUCCESS;
+	p_defer = &g_defer[head & (DEFER_NUM - 1)];
+	p_defer-> param = param;
+	SMP_WMB();
+	p_defer-> func = func;
+
+	// only the first post after the defer task went to sleep wakes it
 
+	if(ATOMIC_CAS(&g_defer_wake, 0, 1) == 0) {
+
+		put_sem(&defer_sem);
+	}
+
+	return SUCCESS;
 }
 
-// timer task function
+// defer task function
 
-static void timer_running_func(void* param) {
+static void defer_running_func(void* param) {
 
-	ListNode* p_node;
-	Timer* p_timer;
+	Defer* p_defer;
+	void (*func)(void*);
 
 	param = param;
 
 	while(1) {
 
-		get_sem(&timer_sem, 1);
+		get_sem(&defer_sem, 1);
 
-		sched_lock();
+		// clear the flag before looking at the slots, or a post in between
+		// could find it still set and never wake us
 
-		p_node = g_timer.next;
+		g_defer_wake = 0;
+		SMP_MB();
 
-		while(p_node != &g_timer) {
+		while(1) {
+
+			p_defer = &g_defer[g_defer_tail & (DEFER_NUM - 1)];
+
+			func = p_defer-> func;
+			if(NULL == func) {
 
-			p_timer = get_list_entry(p_node, Timer, list);
-			if(p_timer-> second > g_tick){
 				break;
 			}
 
-			p_node = p_node->next;
-			list_delete(&p_timer-> list);
-			p_timer->func(p_timer-> param);
-		}
+			// param was stored before func
 
-		sched_unlock();
+			SMP_RMB();
+			param = p_defer-> param;
+			p_defer-> func = NULL;
+
+			// the slot is empty before the isr may reserve it again
+
+			SMP_MB();
+			g_defer_tail ++;
+
+			func(param);
+		}
 	}
 }
 
@@ -1224,13 +6182,60 @@ static void idle_running_func(void* param) {
 
 }
 
+// monotonic time in nanoseconds from the port clock, finer than the tick
+
+u64 os_now_ns() {
+
+	return GET_NS();
+}
+
+// tick count since os start
+
+u64 get_tick() {
+
+	u64 tick;
+
+	DISABLE_IE();
+	tick = g_tick;
+	ENABLE_IE();
+
+	return tick;
+}
+
 // function called by timer isr
 
 void timer_isr_func() {
 
+	Timer* p_timer;
+
 	g_tick ++;
 
-	put_sem(&timer_sem);
+	charge_budget();
+
+	// hard timers run right here
+
+	SPIN_LOCK(&g_hard_timer_lock);
+
+	while(!is_list_empty(&g_hard_timer)) {
+
+		p_timer = get_list_entry(g_hard_timer.next, Timer, list);
+		if(p_timer-> second > g_tick){
+			break;
+		}
+
+		expire_timer(&g_hard_timer, p_timer);
+		run_timer_func(p_timer);
+	}
+
+	SPIN_UNLOCK(&g_hard_timer_lock);
+
+	// wake the timer task only when some timer runs out of slack
+
+	if(!g_timer_wake && g_tick >= g_timer_due) {
+
+		g_timer_wake = 1;
+		put_sem(&timer_sem);
+	}
 }
 
 // for test variable
@@ -1257,6 +6262,48 @@ int main(int argc, char* argv[]) {
 
 	test_timer();
 
+	//test_lock();
+
+	//test_defer();
+
+	//test_slack();
+
+	//test_clock();
+
+	//test_edf();
+
+	//test_budget();
+
+	//test_period();
+
+	//test_notify();
+
+	//test_channel();
+
+	//test_select();
+
+	//test_pubsub();
+
+	//test_queue();
+
+	//test_stream();
+
+	//test_urgent();
+
+	//test_latest();
+
+	//test_rwlock();
+
+	//test_cond();
+
+	//test_ceiling();
+
+	//test_barrier();
+
+	//test_sem_n();
+
+	//test_work();
+
 	os_start();
 
 	return 0;
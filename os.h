@@ -16,6 +16,28 @@
 #define IN_IRQ           10
 #define TIMER_NOT_RUN    11
 #define SELF_KILL_FORBID 12
+#define OVER_UTIL        13
+#define TIMEOUT          14
+#define POOL_EMPTY       15
+#define PRIO_CEILING     16
+#define SEM_FULL         17
+#define SEM_FLUSHED      18
+#define NOT_SERVER       19
+
+// timeout of a timed wait, in ticks
+
+#define NO_WAIT      0
+#define WAIT_FOREVER 0xffffffff
+
+// smp configuration. the object and run queue locks mark the lock order a
+// smp port needs, but the scheduler still keeps one current_task and holds
+// the run queue lock across port_task_switch, so only one cpu is supported
+
+#define OS_CPU_NUM 1
+
+#if OS_CPU_NUM > 1
+#error "the scheduler runs on one cpu, OS_CPU_NUM > 1 needs per-cpu tasks"
+#endif
 
 // data type definition
 
@@ -38,6 +60,41 @@
 #define BLOCKED 0x3
 #define DIE     0x4
 
+// task priority, 0 is the highest
+
+#define PRIO_NUM     32
+#define DEFER_PRIO   0
+#define TIMER_PRIO   1
+#define DEFAULT_PRIO 16
+#define IDLE_PRIO    (PRIO_NUM - 1)
+
+// earliest deadline first tasks, they run before every priority level
+// from EDF_PRIO on. utilization is scaled so EDF_UTIL_MAX means 100%
+
+#define EDF_TASK_NUM 32
+#define EDF_PRIO     2
+#define EDF_UTIL_MAX 1024
+
+// what happens to the tasks of a cpu budget once it runs out, demoted tasks
+// drop to the budget priority, suspended ones leave the run queue
+
+#define BUDGET_DEMOTE  0x1
+#define BUDGET_SUSPEND 0x2
+
+// deferred isr work slots, power of two
+
+#define DEFER_NUM 64
+
+// most work items a worker takes out of its work queue in one go
+
+#define WORK_BATCH 8
+
+// how a notification changes the notify value of a task
+
+#define NOTIFY_SET_BITS  0x1
+#define NOTIFY_INC       0x2
+#define NOTIFY_OVERWRITE 0x3
+
 // object type
 
 #define SEM_TYPE    0x1
@@ -45,6 +102,21 @@
 #define MAIL_TYPE   0x3
 #define BUF_TYPE    0x4
 #define EVENT_TYPE  0x5
+#define CHAN_TYPE   0x6
+#define QUEUE_TYPE  0x7
+#define STREAM_TYPE 0x8
+#define PRIO_BUF_TYPE 0x9
+#define RW_TYPE     0xA
+#define COND_TYPE   0xB
+#define BARRIER_TYPE 0xC
+
+// count word flag, set while tasks sleep on a sem or mutex
+
+#define HAS_WAITER 0x80000000
+
+// rwlock count word, a writer holds it or the low bits count readers
+
+#define RW_WRITER  0x40000000
 
 // link list
 
@@ -57,6 +129,30 @@ typedef struct _ListNode {
 #define get_list_entry(node, type, member) ((type *)((u8 *)(node) - (u32)(&((type *)0)->member)))
 
 
+// timer struct
+
+#define TIMER_IDLE (~(u64) 0)
+
+typedef struct _Timer {
+
+	ListNode list;
+	u32 val;
+	u32 period;
+	u32 slack;
+	u64 second;
+	void (*func)(void*);
+	void* param;
+
+	u8 hard;
+	struct _TimerService* service;
+	ListNode run;
+
+	u32 overrun;	// periods skipped because the timer task was late
+	u32 max_late;	// worst ticks between deadline and callback
+	u64 exec_max;	// slowest callback run in ns
+
+}Timer;
+
 // task struct
 
 typedef struct _Task {
@@ -67,10 +163,17 @@ typedef struct _Task {
 	void* param;
 
 	u32 state;
+	u8 prio;
+	u8 base_prio;	// prio without donation from a channel client
+	ListNode ceiling_held;	// held mutexes with a ceiling
 
 	void* msg;
 
 	void* buf_msg;
+	void* queue_item;	// where a waiting get_queue() wants its item
+	u32 sem_need;	// units a waiting get_sem_n() wants, 0 once flushed
+	u8 cond_signaled;	// a signal moved the wait_cond() caller to the mutex
+	struct _Cond* cond_wait;	// the cond a wait_cond() caller sleeps on
 
 	u32 event_opt;
 	u32 event_val;
@@ -78,6 +181,55 @@ typedef struct _Task {
 
 	ListNode rdy;	
 	ListNode blk;
+	u32* blk_lock;
+
+	u64 blk_ns;	// os_now_ns() when the task last blocked
+	u64 wake_ns;	// os_now_ns() when it was last made ready again
+
+	// periodic task, period, deadline and releases in ticks
+
+	u32 period;
+	u32 deadline;
+	u64 release;
+	u64 abs_deadline;
+	u64 release_ns;	// os_now_ns() at the current release
+	Timer release_timer;
+	u32 deadline_miss;
+	u64 jitter_max;	// worst ns from release to the job getting the cpu
+	u64 response_max;	// worst ns from release to the job finishing
+
+	// earliest deadline first class, runtime in ticks
+
+	u8 edf;
+	u32 edf_runtime;
+	u32 edf_index;
+
+	struct _Budget* budget;
+	ListNode budget_node;
+
+	// direct notification, guarded by the run queue lock
+
+	u32 notify_val;
+	u8 notify_pending;
+	u8 notify_wait;
+
+	Timer wait_timer;	// ends a timed wait
+	u8 wait_timeout;
+	// synchronous channel, a client carries its request and reply, a
+	// server remembers the client it is serving
+
+	void* ipc_msg;
+	void* ipc_reply;
+	u8 ipc_wait;	// received and waiting for the reply
+	struct _Task* ipc_client;
+	struct _Task* ipc_server;	// the server that received a client
+	struct _Channel* ipc_chan;	// the channel a server receives on
+	u8 ipc_lent;	// prio lent by the client being served, PRIO_NUM for none
+	// select, the items a task waits on
+
+	u8 sel_wait;
+	struct _SelectItem* sel_item;
+	u32 sel_num;
 }Task;
 
 
@@ -86,8 +238,11 @@ typedef struct _Task {
 typedef struct _Sem {
 
 	u32 blk_type;
+	u32 lock;
 	ListNode head;
+	ListNode sel;	// select items waiting on the object
 	u32 count;
+	u32 max;	// put beyond it fails with SEM_FULL, 0 for no limit
 }Sem;
 
 
@@ -96,19 +251,70 @@ typedef struct _Sem {
 typedef struct _Mutex {
 
 	u32 blk_type;
+	u32 lock;
 	ListNode head;
 	u32 count;
 	Task* owner;
+	u32 nest;	// extra get_mutex of a recursive owner
+	u8 recursive;
+	u8 ceiling;	// the owner runs at this prio, NO_CEILING for none
+	ListNode held;	// on the owner ceiling_held list while it holds
 }Mutex;
 
+#define NO_CEILING PRIO_NUM
+
+
+// condition variable struct, bound to the mutex that guards the predicate.
+// a signaled waiter moves over to the mutex wait list
+
+typedef struct _Cond {
+
+	u32 blk_type;
+	u32 lock;
+	ListNode head;
+	Mutex* p_mutex;
+}Cond;
+
+
+// barrier struct, parties tasks meet before any goes on. gen counts the
+// phases, a waiter sleeps until it moves past the one it arrived in
+
+typedef struct _Barrier {
+
+	u32 blk_type;
+	u32 lock;
+	ListNode head;
+	u32 parties;
+	u32 count;	// arrived in this phase
+	u32 gen;
+}Barrier;
+
+
+// rwlock struct, readers share it and a writer has it alone. new readers
+// queue up once a writer waits, so writers never starve
+
+typedef struct _Rwlock {
+
+	u32 blk_type;
+	u32 lock;
+	ListNode head;	// waiting readers
+	ListNode wr;	// waiting writers
+	u32 count;
+	Task* owner;	// the writer
+}Rwlock;
+
 
 // mail box struct
 
 typedef struct _Mailbox {
 
 	u32 blk_type;
+	u32 lock;
 	ListNode head;
+	ListNode sel;
 	void* msg;
+	u8 overwrite;	// put_mail replaces an unread msg
+	u32 seq;	// odd while msg changes, see peek_mail()
 }Mailbox;
 
 
@@ -117,7 +323,9 @@ typedef struct _Mailbox {
 typedef struct _Msgbuf {
 
 	u32 blk_type;
+	u32 lock;
 	ListNode head;
+	ListNode sel;
 	void** pp_msg;
 	u32 size;
 	u32 count;
@@ -126,6 +334,108 @@ typedef struct _Msgbuf {
 
 }Msgbuf;
 
+// priority msg buffer struct, one fifo of nodes per level and a bitmap of
+// the non-empty ones, level 0 is the most urgent
+
+#define MSG_PRIO_NUM 8
+
+typedef struct _MsgNode {
+
+	void* msg;
+	struct _MsgNode* next;
+}MsgNode;
+
+typedef struct _PrioMsgbuf {
+
+	u32 blk_type;
+	u32 lock;
+	ListNode head;
+	ListNode sel;
+	MsgNode* free;
+	MsgNode* first[MSG_PRIO_NUM];
+	MsgNode* last[MSG_PRIO_NUM];
+	u32 bitmap;
+	u32 count;
+
+}PrioMsgbuf;
+
+// queue struct, items of item_size bytes are copied in and out of a ring
+// in the caller's buffer instead of passing pointers
+
+typedef struct _Queue {
+
+	u32 blk_type;
+	u32 lock;
+	ListNode head;
+	u8* p_buf;
+	u32 item_size;
+	u32 size;
+	u32 count;
+	u32 start;
+	u32 end;
+
+}Queue;
+
+// stream struct, a byte ring for one writer and one reader. in and out
+// count bytes written and read, each moved by one side only, so neither
+// side takes a lock unless the reader sleeps. size is a power of two
+
+typedef struct _Stream {
+
+	u32 blk_type;
+	u32 lock;
+	ListNode head;
+	u8* p_buf;
+	u32 size;
+	u32 trigger;	// bytes a sleeping reader waits for
+	u32 in;
+	u32 out;
+	u32 wait;	// set while the reader sleeps, the writer then wakes it
+	u32 need;	// bytes the sleeping reader waits for
+}Stream;
+
+// message pool struct, fixed size blocks handed out without the heap. a
+// block goes back to the pool once its last reference is released
+
+typedef struct _MsgHead {
+
+	struct _MsgPool* pool;
+	u32 ref;
+	struct _MsgHead* next;
+}MsgHead;
+
+#define MSG_HEAD_SIZE ((sizeof(MsgHead) + 7) & ~7)
+#define MSG_POOL_SIZE(size, num) ((MSG_HEAD_SIZE + (((size) + 7) & ~7)) * (num))
+
+typedef struct _MsgPool {
+
+	u32 lock;
+	void* free;
+	u32 free_num;
+	u32 size;
+}MsgPool;
+
+// topic struct, a published message goes to the msg buffer of every
+// subscriber as one reference counted pool block. publish_msg() copies the
+// subscribers out under the topic lock, so a topic takes at most
+// TOPIC_SUB_NUM of them
+
+#define TOPIC_SUB_NUM 16
+
+typedef struct _Topic {
+
+	u32 lock;
+	ListNode head;
+	u32 sub_num;
+}Topic;
+
+typedef struct _Subscriber {
+
+	ListNode node;
+	Msgbuf* p_msg_buf;
+	u32 drop;	// messages lost to a full msg buffer
+}Subscriber;
+
 // event struct
 
 #define AND_OPTION 0x1
@@ -134,21 +444,122 @@ typedef struct _Msgbuf {
 typedef struct _Event {
 
 	u32 blk_type;
+	u32 lock;
 	ListNode head;
+	ListNode sel;
 	u32 val;
 }Event;
 
-// timer struct
+// select item, one per object a task waits on in select_wait()
 
-typedef struct _Timer {
+typedef struct _SelectItem {
+
+	void* obj;	// Sem, Mailbox, Msgbuf, PrioMsgbuf or Event
+	u32 event_val;	// event bits, any of them will do
+	ListNode node;
+	Task* task;
+}SelectItem;
+
+// channel struct, clients wait on head until a server receives them,
+// servers wait on recv until a client sends
+
+typedef struct _Channel {
+
+	u32 blk_type;
+	u32 lock;
+	ListNode head;
+	ListNode recv;
+	Task* server;	// last task that received, it inherits client priority
+}Channel;
+
+// timer service struct, a task running the callbacks of its timers
+
+typedef struct _TimerService {
+
+	Task task;
+	Sem sem;
+	u32 lock;
+	ListNode head;
+}TimerService;
+
+// work queue struct, a pool of worker tasks runs func(param) of the work
+// submitted to it. the items live in a ring of size slots
+
+typedef struct _WorkItem {
 
-	ListNode list;
-	u32 val;
-	u64 second;
 	void (*func)(void*);
 	void* param;
+	u64 submit_ns;
+}WorkItem;
 
-}Timer;
+typedef struct _Workqueue {
+
+	u32 lock;
+	WorkItem* p_buf;
+	u32 size;
+	u32 start;
+	u32 count;
+	u32 batch;	// items a worker takes per pass
+	Sem sem;	// idle workers sleep here
+	u32 idle;	// workers asleep and not woken yet
+	u32 workers;
+
+	u32 depth_max;
+	u32 full;	// submits refused because the ring was full
+	u32 done;
+	u32 wakeups;
+	u64 latency_sum;	// ns between submit and start of the items done
+	u64 latency_max;
+}Workqueue;
+
+// statistics of a work queue, see get_workqueue_stat()
+
+typedef struct _WorkStat {
+
+	u32 depth;
+	u32 depth_max;
+	u32 full;
+	u32 done;
+	u32 wakeups;
+	u64 latency_avg;
+	u64 latency_max;
+}WorkStat;
+
+// work submitted after delay ticks, through a timer
+
+typedef struct _DelayedWork {
+
+	Timer timer;
+	Workqueue* p_wq;
+	void (*func)(void*);
+	void* param;
+}DelayedWork;
+
+// cpu budget struct, its tasks may run budget ticks every period ticks in
+// total, then they are throttled until the next refill
+
+typedef struct _Budget {
+
+	u32 budget;
+	u32 period;
+	u32 left;
+	u8 action;
+	u8 prio;	// priority of demoted tasks
+	u8 throttled;
+	ListNode task;
+	ListNode parked;	// ready tasks held back while suspended
+	Timer timer;
+
+	u64 used;	// ticks charged since creation
+	u32 throttle_count;	// times the budget ran out
+	u64 throttle_ticks;	// ticks spent throttled
+	u64 throttle_start;
+}Budget;
+
+// kernel api not returning STATUS
+
+u64 get_tick();
+u64 os_now_ns();
 
 // function ready to port
 
@@ -156,9 +567,38 @@ typedef struct _Timer {
 #define ENABLE_IE() port_exit_critical()
 #define INIT_STACK_DATA(task, base, size, entry, param) port_stack_init(task, base, (size >> 2), param, entry)
 #define CONTEXT_SWITCH()   port_task_switch();
+#define ATOMIC_CAS(p_val, old_val, new_val) port_atomic_cas(p_val, old_val, new_val)
+#define CPU_RELAX() port_cpu_relax()
+#define SMP_MB()  port_mb()
+#define SMP_RMB() port_rmb()
+#define SMP_WMB() port_wmb()
+#define GET_NS() port_get_ns()
+#define TICK_NS() port_tick_ns()
 #define START_FIRST_TASK() raw_start_first_task()
 #define is_in_irq() (g_irq)
 
+// index of the running cpu, always 0 while OS_CPU_NUM is 1
+
+#define CPU_ID() 0
+
+// kernel locks, always taken in this order:
+//   DISABLE_IE() -> object lock -> run queue lock
+// object lock guards one object (count, msg, blk list), run queue lock
+// guards g_run_queue and task state. on a single cpu DISABLE_IE() is enough
+
+#if OS_CPU_NUM > 1
+#define SPIN_LOCK(p_lock)   port_spin_lock(p_lock)
+#define SPIN_UNLOCK(p_lock) port_spin_unlock(p_lock)
+#else
+#define SPIN_LOCK(p_lock)
+#define SPIN_UNLOCK(p_lock)
+#endif
+
+#define OBJ_LOCK(p_obj)   SPIN_LOCK(&(p_obj)-> lock)
+#define OBJ_UNLOCK(p_obj) SPIN_UNLOCK(&(p_obj)-> lock)
+#define RDY_LOCK()        SPIN_LOCK(&g_rdy_lock)
+#define RDY_UNLOCK()      SPIN_UNLOCK(&g_rdy_lock)
+
 #endif
 
 
@@ -41,6 +41,7 @@
 #include 	<stdarg.h>
 #include	<windows.h>
 #include	<mmsystem.h>
+#include	<intrin.h>
 #include  	<assert.h> 
 
 
@@ -89,6 +90,15 @@ static void *timer_event = NULL;
 by multiple threads. */
 static void *cpu_global_interrupt_mask = NULL;
 
+/* Nesting depth of the critical section and the thread holding it. The
+simulated interrupt thread runs alongside the task thread, so a thread only
+trusts the depth once cpu_critical_owner is its own id. Both are written
+only by the thread that owns cpu_global_interrupt_mask, the mutex is taken
+once at the outermost level and nested DISABLE_IE() calls are a plain
+increment. */
+static u32 cpu_critical_nest;
+static DWORD cpu_critical_owner;
+
 unsigned long port_interrupt_switch;
 
 int port_switch_flag;
@@ -286,6 +296,8 @@ static void simulated_interrupt_process( void )
 		}
 
 		g_irq ++;
+		cpu_critical_owner = GetCurrentThreadId();
+		cpu_critical_nest = 1;
 
 		if (simulated_interrupt_fun) {
 			simulated_interrupt_fun();
@@ -293,6 +305,9 @@ static void simulated_interrupt_process( void )
 		}
 
 		timer_isr_func();
+
+		cpu_critical_nest = 0;
+		cpu_critical_owner = 0;
 		g_irq --;
 
 
@@ -302,6 +317,8 @@ static void simulated_interrupt_process( void )
 }
 
 
+extern u32 g_rdy_lock;
+
 void port_task_switch(void)
 {
 	/*global interrupt is disabled here so it is safe to change value here*/
@@ -310,6 +327,12 @@ void port_task_switch(void)
 
 	xThreadState* pxThreadState_sched = ( xThreadState * ) ( *( unsigned long *) sched_task );
 
+	/* the nesting depth belongs to the task being switched out, clear it
+	before the next thread can run so it takes the mutex for itself */
+	u32 saved_nest = cpu_critical_nest;
+
+	cpu_critical_nest = 0;
+	cpu_critical_owner = 0;
 	current_task = sched_task;
 
 	if(pxThreadState_sched-> state == CREATED) {
@@ -325,11 +348,17 @@ void port_task_switch(void)
 		SetEvent(pxThreadState_sched-> hSigEvent);
 	}
 
-	port_exit_critical();
+	/* the run queue lock is handed over together with the cpu, the same
+	way the simulated interrupt mask is released below */
+	RDY_UNLOCK();
+	ReleaseMutex(cpu_global_interrupt_mask);
 
 	WaitForSingleObject(pxThreadState_cur-> hSigEvent, INFINITE);
 
-	port_enter_critical();
+	WaitForSingleObject(cpu_global_interrupt_mask, INFINITE);
+	cpu_critical_owner = GetCurrentThreadId();
+	cpu_critical_nest = saved_nest;
+	RDY_LOCK();
 }
 
 extern u32 g_running;
@@ -340,7 +369,15 @@ void port_enter_critical()
 	
 		/* The interrupt event mutex is held for the entire critical section,
 		effectively disabling (simulated) interrupts. */
-		WaitForSingleObject(cpu_global_interrupt_mask, INFINITE);
+		if (cpu_critical_owner != GetCurrentThreadId()) {
+
+			WaitForSingleObject(cpu_global_interrupt_mask, INFINITE);
+
+			cpu_critical_owner = GetCurrentThreadId();
+			cpu_critical_nest = 0;
+		}
+
+		cpu_critical_nest ++;
 	}
 }
 
@@ -357,7 +394,96 @@ void port_exit_critical()
 		return; 
 	}
 	
-	ReleaseMutex(cpu_global_interrupt_mask);
+	cpu_critical_nest --;
+
+	if (cpu_critical_nest == 0) {
+
+		cpu_critical_owner = 0;
+		ReleaseMutex(cpu_global_interrupt_mask);
+	}
+
+}
+
+
+
+/* spin lock used for kernel objects when OS_CPU_NUM > 1, the caller has
+already entered the critical section so the holder can not be interrupted */
+void port_spin_lock(u32* p_lock)
+{
+	while (InterlockedCompareExchange((LONG volatile*) p_lock, 1, 0) != 0) {
+
+		while (*(volatile u32*) p_lock) {
+
+			YieldProcessor();
+		}
+	}
+}
+
+
+
+void port_spin_unlock(u32* p_lock)
+{
+	InterlockedExchange((LONG volatile*) p_lock, 0);
+}
+
+
 
+void port_cpu_relax(void)
+{
+	YieldProcessor();
+}
+
+
+
+/* memory barriers for data shared without a lock. x86 only lets a later
+load pass an earlier store, so the full barrier fences and the read and
+write barriers just keep the compiler from moving accesses across */
+void port_mb(void)
+{
+	MemoryBarrier();
+}
+
+void port_rmb(void)
+{
+	_ReadWriteBarrier();
+}
+
+void port_wmb(void)
+{
+	_ReadWriteBarrier();
+}
+
+
+
+unsigned int port_atomic_cas(unsigned int* p_val, unsigned int old_val, unsigned int new_val)
+{
+	return (unsigned int) InterlockedCompareExchange((LONG volatile*) p_val, (LONG) new_val, (LONG) old_val);
+}
+
+
+
+/* monotonic clock backing os_now_ns(), the performance counter runs at a
+fixed frequency far above the tick rate */
+unsigned long long port_get_ns(void)
+{
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER count;
+
+	if (freq.QuadPart == 0) {
+
+		QueryPerformanceFrequency(&freq);
+	}
+
+	QueryPerformanceCounter(&count);
+
+	return (unsigned long long) (count.QuadPart / freq.QuadPart) * 1000000000 +
+		(unsigned long long) (count.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+}
+
+
+
+unsigned int port_tick_ns(void)
+{
+	return vc_timer_value * 1000000;
 }
 
@@ -39,6 +39,25 @@ void raw_int_switch(void);
 void port_task_switch(void);
 void raw_start_first_task(void); 
 
+/*spin lock for kernel objects on smp host*/
+void port_spin_lock(unsigned int* p_lock);
+void port_spin_unlock(unsigned int* p_lock);
+
+/*pause inside a busy wait loop*/
+void port_cpu_relax(void);
+
+/*full, read and write memory barriers*/
+void port_mb(void);
+void port_rmb(void);
+void port_wmb(void);
+
+/*compare and swap, returns the value seen before the swap*/
+unsigned int port_atomic_cas(unsigned int* p_val, unsigned int old_val, unsigned int new_val);
+
+/*monotonic clock in ns and the length of one tick in ns*/
+unsigned long long port_get_ns(void);
+unsigned int port_tick_ns(void);
+
 
 #define  RAW_ASSERT(CON)    if (!(CON)) { \
 								volatile RAW_U8 dummy = 0; \
@@ -0,0 +1,107 @@
+
+#include "os.h"
+
+#define STAGE_NUM 4
+#define PHASE_NUM 100000
+
+static Task stage[STAGE_NUM];
+static Task coordinator;
+
+static u8 stage_stack[STAGE_NUM][1024];
+static u8 coordinator_stack[1024];
+
+static Barrier bar;
+static Sem done;
+static Sem go[STAGE_NUM];
+
+static u32 work[STAGE_NUM];
+
+static char* mode_name[3] = {"barrier", "sem + coordinator", "spin_barrier"};
+
+// every stage does one step per phase. the phases run in turn through the
+// barrier, through semaphores and a coordinator, and through spin_barrier
+
+static void run_stage(void* param){
+
+	u32 id;
+	u32 phase;
+	u32 mode;
+	u64 start;
+
+	id = (u32) param;
+
+	start = os_now_ns();
+
+	for(phase = 0; ; phase ++) {
+
+		mode = (phase / PHASE_NUM) % 3;
+
+		if(!id && phase && !(phase % PHASE_NUM)) {
+
+			vc_port_printf("%s: %dns per phase\n", mode_name[(mode + 2) % 3],
+				(u32) ((os_now_ns() - start) / PHASE_NUM));
+
+			start = os_now_ns();
+		}
+
+		work[id] ++;
+
+		if(0 == mode) {
+
+			wait_barrier(&bar);
+
+		}else if(1 == mode) {
+
+			put_sem(&done);
+			get_sem(&go[id], 1);
+
+		}else {
+
+			spin_barrier(&bar, 100);
+		}
+	}
+}
+
+static void run_coordinator(void* param){
+
+	u32 i;
+
+	param = param;
+
+	while(1) {
+
+		for(i = 0; i < STAGE_NUM; i ++) {
+
+			get_sem(&done, 1);
+		}
+
+		for(i = 0; i < STAGE_NUM; i ++) {
+
+			put_sem(&go[i]);
+		}
+	}
+}
+
+extern int global_test;
+
+void test_barrier() {
+
+	u32 i;
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_barrier(&bar, STAGE_NUM);
+		create_sem(&done, 0);
+
+		for(i = 0; i < STAGE_NUM; i ++) {
+
+			create_sem(&go[i], 0);
+			create_task(&stage[i], run_stage, (void*) i, stage_stack[i], 1024);
+		}
+
+		create_task(&coordinator, run_coordinator, NULL, coordinator_stack, 1024);
+	}
+
+}
@@ -0,0 +1,90 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+static Task task3;
+static Task task4;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+static u8 task3_stack[1024];
+static u8 task4_stack[1024];
+
+static Budget budget1;
+static Budget budget2;
+
+static u32 count[4];
+
+// runaway task, never blocks and only yields to its own priority
+
+static void run_busy(void* param){
+
+	u32 index = (u32) param;
+
+	while(1) {
+
+		count[index] ++;
+
+		yield();
+	}
+}
+
+// ordinary task below the runaway ones, it only runs once they are throttled
+
+static void run_report(void* param){
+
+	u64 next;
+
+	param = param;
+	next = get_tick() + 100;
+
+	while(1) {
+
+		count[3] ++;
+
+		if(get_tick() >= next) {
+
+			next += 100;
+
+			vc_port_printf("group used %d throttled %d for %d ticks, task3 used %d throttled %d, count %d %d %d %d\n",
+				(u32) budget1.used, budget1.throttle_count, (u32) budget1.throttle_ticks,
+				(u32) budget2.used, budget2.throttle_count, count[0], count[1], count[2], count[3]);
+		}
+
+		yield();
+	}
+}
+
+extern int global_test;
+
+void test_budget() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		// task1 and task2 share 2 ticks in 10 and are suspended past that
+
+		create_budget(&budget1, 2, 10, BUDGET_SUSPEND, 0);
+
+		create_task(&task1, run_busy, (void*) 0, task1_stack, 1024);
+		set_task_prio(&task1, DEFAULT_PRIO - 2);
+		set_task_budget(&task1, &budget1);
+
+		create_task(&task2, run_busy, (void*) 1, task2_stack, 1024);
+		set_task_prio(&task2, DEFAULT_PRIO - 2);
+		set_task_budget(&task2, &budget1);
+
+		// task3 gets 3 ticks in 10 and then drops below task4
+
+		create_budget(&budget2, 3, 10, BUDGET_DEMOTE, IDLE_PRIO - 1);
+
+		create_task(&task3, run_busy, (void*) 2, task3_stack, 1024);
+		set_task_prio(&task3, DEFAULT_PRIO - 1);
+		set_task_budget(&task3, &budget2);
+
+		create_task(&task4, run_report, NULL, task4_stack, 1024);
+	}
+
+}
@@ -0,0 +1,149 @@
+
+#include "os.h"
+
+static Task high;
+static Task medium;
+static Task low;
+
+static u8 high_stack[1024];
+static u8 medium_stack[1024];
+static u8 low_stack[1024];
+
+static Mutex mutex;
+
+static u32 latency_max;
+static u32 switched;
+
+#define HIGH_PRIO   10
+#define MEDIUM_PRIO 15
+#define LOW_PRIO    20
+
+// run for some ticks, yield() only lets tasks of the same or higher prio in
+
+static void busy(u32 ticks) {
+
+	u64 start;
+
+	start = get_tick();
+
+	while(get_tick() < start + ticks) {
+
+		yield();
+	}
+}
+
+// every 20 ticks, how long until the mutex is ours
+
+static void run_high(void* param){
+
+	u64 start;
+	u32 latency;
+
+	param = param;
+
+	while(1) {
+
+		start = get_tick();
+
+		get_mutex(&mutex, 1);
+
+		// the first wait after a switch may have started before it
+
+		latency = (u32) (get_tick() - start);
+		if(switched) {
+
+			switched = 0;
+
+		}else if(latency > latency_max) {
+
+			latency_max = latency;
+		}
+
+		put_mutex(&mutex);
+
+		wait_next_period();
+	}
+}
+
+// takes no lock but keeps the cpu for 10 of every 20 ticks
+
+static void run_medium(void* param){
+
+	param = param;
+
+	while(1) {
+
+		busy(10);
+
+		wait_next_period();
+	}
+}
+
+// holds the mutex 2 ticks at a time, taken twice by nested code. every
+// 400 ticks the ceiling is switched on or off
+
+static void run_low(void* param){
+
+	u64 start;
+
+	param = param;
+
+	start = get_tick();
+
+	while(1) {
+
+		if(get_tick() >= start + 400) {
+
+			start = get_tick();
+
+			vc_port_printf("ceiling %s: high waits up to %d ticks\n",
+				NO_CEILING == mutex.ceiling ? "off" : "on", latency_max);
+
+			latency_max = 0;
+			switched = 1;
+			set_mutex_ceiling(&mutex, NO_CEILING == mutex.ceiling ? HIGH_PRIO : NO_CEILING);
+		}
+
+		get_mutex(&mutex, 1);
+		get_mutex(&mutex, 1);
+
+		busy(2);
+
+		put_mutex(&mutex);
+
+		if(low.prio != (NO_CEILING == mutex.ceiling ? LOW_PRIO : HIGH_PRIO)) {
+
+			vc_port_printf("wrong prio %d inside the nested mutex\n", low.prio);
+		}
+
+		put_mutex(&mutex);
+
+		if(LOW_PRIO != low.prio) {
+
+			vc_port_printf("wrong prio %d after the mutex\n", low.prio);
+		}
+	}
+}
+
+extern int global_test;
+
+void test_ceiling() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_mutex(&mutex);
+		set_mutex_recursive(&mutex, 1);
+
+		create_periodic_task(&high, run_high, NULL, high_stack, 1024, 20, 0);
+		set_task_prio(&high, HIGH_PRIO);
+
+		create_periodic_task(&medium, run_medium, NULL, medium_stack, 1024, 20, 0);
+		set_task_prio(&medium, MEDIUM_PRIO);
+
+		create_task(&low, run_low, NULL, low_stack, 1024);
+		set_task_prio(&low, LOW_PRIO);
+	}
+
+}
@@ -0,0 +1,130 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+
+static Channel chan;
+static Mailbox request;
+static Mailbox reply;
+static Mutex lock;
+
+static u32 after_reply;
+
+#define ROUND_NUM 10000
+
+// client, times the same rpc through a channel and through two mailboxes
+
+static void run_client(void* param){
+
+	u64 start;
+	u64 chan_ns;
+	u64 mail_ns;
+	void* msg;
+	u32 i;
+
+	param = param;
+
+	start = os_now_ns();
+
+	for(i = 0; i < ROUND_NUM; i ++) {
+
+		send_channel(&chan, (void*) (i + 1), &msg);
+	}
+
+	chan_ns = os_now_ns() - start;
+
+	start = os_now_ns();
+
+	for(i = 0; i < ROUND_NUM; i ++) {
+
+		put_mail(&request, (void*) (i + 1));
+		get_mail(&reply, &msg, 1);
+	}
+
+	mail_ns = os_now_ns() - start;
+
+	vc_port_printf("%d rpcs: channel %dns, two mailboxes %dns each\n", ROUND_NUM,
+		(u32) (chan_ns / ROUND_NUM), (u32) (mail_ns / ROUND_NUM));
+
+	send_channel(&chan, NULL, &msg);
+
+	vc_port_printf("server ran at prio %d, client prio %d\n", (u32) msg, task1.prio);
+
+	// the server holds a mutex with a ceiling now, the reply must keep it
+
+	send_channel(&chan, NULL, &msg);
+
+	vc_port_printf("server ran at prio %d, %d after the reply, ceiling %d\n", (u32) msg, after_reply, lock.ceiling);
+
+	vc_port_printf("reply from a non-server: %s\n", NOT_SERVER == reply_channel(&task2, NULL) ? "NOT_SERVER" : "accepted");
+
+	while(1) {
+
+		yield();
+	}
+}
+
+// server, runs below the client and borrows its priority while serving
+
+static void run_server(void* param){
+
+	Task* p_client;
+	void* msg;
+	u32 i;
+
+	param = param;
+
+	for(i = 0; i < ROUND_NUM; i ++) {
+
+		receive_channel(&chan, &msg, &p_client, 1);
+		reply_channel(p_client, msg);
+	}
+
+	for(i = 0; i < ROUND_NUM; i ++) {
+
+		get_mail(&request, &msg, 1);
+		put_mail(&reply, msg);
+	}
+
+	receive_channel(&chan, &msg, &p_client, 1);
+	reply_channel(p_client, (void*) (u32) task2.prio);
+
+	while(1) {
+
+		get_mutex(&lock, 1);
+
+		receive_channel(&chan, &msg, &p_client, 1);
+		reply_channel(p_client, (void*) (u32) task2.prio);
+
+		after_reply = task2.prio;
+
+		put_mutex(&lock);
+	}
+}
+
+extern int global_test;
+
+void test_channel() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_channel(&chan);
+		create_mail(&request, NULL);
+		create_mail(&reply, NULL);
+		create_mutex(&lock);
+		set_mutex_ceiling(&lock, DEFAULT_PRIO - 2);
+
+		create_task(&task1, run_client, NULL, task1_stack, 1024);
+		set_task_prio(&task1, DEFAULT_PRIO - 1);
+
+		create_task(&task2, run_server, NULL, task2_stack, 1024);
+		set_task_prio(&task2, DEFAULT_PRIO + 1);
+	}
+
+}
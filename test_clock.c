@@ -0,0 +1,71 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+
+static Sem sem;
+static Timer timer;
+
+static void timer_func(void* param){
+
+	param = param;
+
+	put_sem(&sem);
+}
+
+// waits for a 25 ms timer, rounded up to the tick, and reports how long it
+// was blocked and how long it took to run after being made ready
+
+static void run_task1(void* param){
+
+	u64 now;
+
+	param = param;
+	
+	while(1) {
+	
+		get_sem(&sem, 1);
+
+		now = os_now_ns();
+		
+		vc_port_printf("blocked %dus, ready to run %dus\n",
+			(u32) ((task1.wake_ns - task1.blk_ns) / 1000), (u32) ((now - task1.wake_ns) / 1000));
+	}
+}
+
+static void run_task2(void* param){
+
+	param = param;
+	
+	create_periodic_timer_ns(&timer, 25000000, 25000000, timer_func, NULL);
+
+	activate_timer(&timer);
+
+	while(1) {
+	
+		yield();
+	}
+}
+
+extern int global_test;
+
+void test_clock() {
+
+	if(!global_test) {
+
+		global_test = 1;
+		
+		create_sem(&sem, 0);
+
+		create_task(&task1, run_task1, NULL, task1_stack, 1024);
+	
+		create_task(&task2, run_task2, NULL, task2_stack, 1024);
+
+	}
+
+}
+
@@ -0,0 +1,120 @@
+
+#include "os.h"
+
+#define WAITER_NUM 4
+
+static Task waiter[WAITER_NUM];
+static Task master;
+static Task sleeper;
+
+static u8 waiter_stack[WAITER_NUM][1024];
+static u8 master_stack[1024];
+static u8 sleeper_stack[1024];
+
+static Mutex mutex;
+static Cond cond;
+static Cond never;
+
+static u32 round;
+static u32 wakeups;
+static u32 timeouts;
+
+// wait for the next round, the predicate is checked with the mutex held
+
+static void run_waiter(void* param){
+
+	u32 seen;
+
+	param = param;
+	seen = 0;
+
+	while(1) {
+
+		get_mutex(&mutex, 1);
+
+		while(seen == round) {
+
+			wait_cond(&cond, WAIT_FOREVER);
+		}
+
+		seen = round;
+		wakeups ++;
+
+		put_mutex(&mutex);
+	}
+}
+
+// start a round every 10 ticks, all waiters go on one after another
+
+static void run_master(void* param){
+
+	u64 start;
+
+	param = param;
+
+	start = get_tick();
+
+	while(1) {
+
+		get_mutex(&mutex, 1);
+
+		round ++;
+		broadcast_cond(&cond);
+
+		put_mutex(&mutex);
+
+		if(get_tick() >= start + 200) {
+
+			start = get_tick();
+
+			vc_port_printf("%d rounds, %d wakeups, %d timeouts\n", round, wakeups, timeouts);
+		}
+
+		wait_next_period();
+	}
+}
+
+// nobody signals this cond, every wait ends with TIMEOUT and the mutex held
+
+static void run_sleeper(void* param){
+
+	param = param;
+
+	while(1) {
+
+		get_mutex(&mutex, 1);
+
+		if(TIMEOUT == wait_cond(&never, 7) && &sleeper == mutex.owner) {
+
+			timeouts ++;
+		}
+
+		put_mutex(&mutex);
+	}
+}
+
+extern int global_test;
+
+void test_cond() {
+
+	u32 i;
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_mutex(&mutex);
+		create_cond(&cond, &mutex);
+		create_cond(&never, &mutex);
+
+		for(i = 0; i < WAITER_NUM; i ++) {
+
+			create_task(&waiter[i], run_waiter, NULL, waiter_stack[i], 1024);
+		}
+
+		create_task(&sleeper, run_sleeper, NULL, sleeper_stack, 1024);
+
+		create_periodic_task(&master, run_master, NULL, master_stack, 1024, 10, 0);
+	}
+
+}
@@ -0,0 +1,58 @@
+
+#include "os.h"
+
+static Task task;
+
+static u8 stack[1024];
+
+static u32 posted;
+static u32 handled;
+
+extern void (*simulated_interrupt_fun)();
+
+static void rx_work(void* param){
+
+	handled = (u32) param;
+
+	if(!(handled % 100)) {
+
+		vc_port_printf("defer %d\n", handled);
+	}
+}
+
+// simulated device interrupt, runs with the tick
+
+static void rx_isr(){
+
+	posted ++;
+
+	post_defer(rx_work, (void*) posted);
+}
+
+static void run_task(void* param){
+
+	param = param;
+	
+	simulated_interrupt_fun = rx_isr;
+
+	while(1) {
+		yield();
+	}
+}
+
+extern int global_test;
+
+void test_defer() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		posted = 0;
+		handled = 0;
+
+		create_task(&task, run_task, NULL, stack, 1024);
+	}
+
+}
+
@@ -0,0 +1,86 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+static Task task3;
+static Task task4;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+static u8 task3_stack[1024];
+static u8 task4_stack[1024];
+
+static u32 slack;
+
+// burn runtime ticks of cpu, then wait for the next release
+
+static void run_edf(void* param){
+
+	Task* p_task = (Task*) param;
+	u64 start;
+	u32 job = 0;
+
+	while(1) {
+
+		start = get_tick();
+
+		while(get_tick() < start + p_task-> edf_runtime) {
+
+		}
+
+		job ++;
+
+		if(!(job % 20)) {
+
+			vc_port_printf("edf runtime %d: %d jobs, %d misses, slack %d\n", p_task-> edf_runtime, job, p_task-> deadline_miss, slack);
+		}
+
+		wait_next_period();
+	}
+}
+
+// ordinary task, only runs when no edf job is ready
+
+static void run_slack(void* param){
+
+	param = param;
+	
+	while(1) {
+	
+		slack ++;
+
+		yield();
+	}
+}
+
+extern int global_test;
+
+void test_edf() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		slack = 0;
+
+		create_task(&task1, run_edf, &task1, task1_stack, 1024);
+		set_task_edf(&task1, 2, 10, 10);
+	
+		create_task(&task2, run_edf, &task2, task2_stack, 1024);
+		set_task_edf(&task2, 3, 20, 15);
+
+		// 20% + 20% + 70% does not fit, so this one stays an ordinary task
+
+		create_task(&task3, run_slack, NULL, task3_stack, 1024);
+
+		if(OVER_UTIL == set_task_edf(&task3, 7, 10, 10)) {
+
+			vc_port_printf("task3 rejected\n");
+		}
+
+		create_task(&task4, run_slack, NULL, task4_stack, 1024);
+	}
+
+}
+
@@ -0,0 +1,110 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+static Task task3;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+static u8 task3_stack[1024];
+
+static Mailbox box;
+
+static u32 sample[4];
+static u32 sample_seq;
+
+// the sensor isr, every tick it writes a fresh sample and overwrites the
+// previous one whether it was read or not. samples rotate through a small
+// array so a pointer stays valid long enough for the readers
+
+static void sensor_isr() {
+
+	u32* p_sample;
+
+	p_sample = &sample[sample_seq & 3];
+	*p_sample = sample_seq ++;
+
+	put_mail(&box, p_sample);
+}
+
+extern void (*simulated_interrupt_fun)();
+
+// readers only look at the latest sample, they never take it
+
+static void run_reader(void* param){
+
+	void* msg;
+	u32 seq;
+	u32 last = 0;
+	u32 fresh = 0;
+	u32 stale = 0;
+
+	while(1) {
+
+		if(SUCCESS == peek_mail(&box, &msg, &seq)) {
+
+			if(seq != last) {
+
+				fresh ++;
+				last = seq;
+
+				if(!(fresh % 100)) {
+
+					vc_port_printf("%s: sample %d, %d fresh %d stale peeks\n", (char*) param, *(u32*) msg, fresh, stale);
+				}
+
+			}else {
+
+				stale ++;
+			}
+		}
+
+		yield();
+	}
+}
+
+// a slow consumer may still take the sample, put_mail never fails
+
+static void run_taker(void* param){
+
+	void* msg;
+	u64 start;
+
+	param = param;
+
+	while(1) {
+
+		get_mail(&box, &msg, 1);
+
+		start = get_tick();
+
+		while(get_tick() < start + 50) {
+
+			yield();
+		}
+	}
+}
+
+extern int global_test;
+
+void test_latest() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_mail(&box, NULL);
+		set_mail_overwrite(&box, 1);
+
+		sample_seq = 0;
+		simulated_interrupt_fun = sensor_isr;
+
+		create_task(&task1, run_reader, "reader1", task1_stack, 1024);
+
+		create_task(&task2, run_reader, "reader2", task2_stack, 1024);
+
+		create_task(&task3, run_taker, NULL, task3_stack, 1024);
+	}
+
+}
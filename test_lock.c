@@ -0,0 +1,108 @@
+#include "os.h"
+
+// uncontended acquire/release cost, each path timed on its own: the atomic
+// fast paths of get_sem/put_sem and get_mutex/put_mutex, and for comparison
+// the same sem round trip through the critical section, which is what every
+// get_sem/put_sem paid before the fast path
+
+#define LOCK_ROUND_NUM 100000
+#define LOCK_WINDOW    100
+
+static Task task;
+static u8 task_stack[1024];
+static Sem sem;
+static Mutex mutex;
+static u32 locked_count;
+
+// get_sem/put_sem without the fast path: mask, check and change the count,
+// unmask, once for each side
+
+static void locked_round_trip() {
+
+	DISABLE_IE();
+
+	if(locked_count > 0) {
+
+		locked_count --;
+	}
+
+	ENABLE_IE();
+
+	DISABLE_IE();
+	locked_count ++;
+	ENABLE_IE();
+}
+
+static void run_task(void* param){
+
+	u64 start;
+	u64 sem_ns;
+	u64 mutex_ns;
+	u64 locked_ns;
+	u64 next;
+	u32 i;
+
+	param = param;
+	
+	while(1) {
+
+		next = get_tick() + LOCK_WINDOW;
+
+		start = os_now_ns();
+
+		for(i = 0; i < LOCK_ROUND_NUM; i ++) {
+
+			get_sem(&sem, 1);
+			put_sem(&sem);
+		}
+
+		sem_ns = os_now_ns() - start;
+
+		start = os_now_ns();
+
+		for(i = 0; i < LOCK_ROUND_NUM; i ++) {
+
+			get_mutex(&mutex, 1);
+			put_mutex(&mutex);
+		}
+
+		mutex_ns = os_now_ns() - start;
+
+		start = os_now_ns();
+
+		for(i = 0; i < LOCK_ROUND_NUM; i ++) {
+
+			locked_round_trip();
+		}
+
+		locked_ns = os_now_ns() - start;
+
+		vc_port_printf("round trip: sem %dns, mutex %dns, sem through the critical section %dns\n",
+			(u32) (sem_ns / LOCK_ROUND_NUM), (u32) (mutex_ns / LOCK_ROUND_NUM), (u32) (locked_ns / LOCK_ROUND_NUM));
+
+		while(get_tick() < next) {
+
+			yield();
+		}
+	}
+}
+
+extern int global_test;
+
+void test_lock() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_sem(&sem, 1);
+
+		create_mutex(&mutex);
+
+		locked_count = 1;
+
+		create_task(&task, run_task, NULL, task_stack, 1024);
+	}
+
+}
+
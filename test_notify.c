@@ -0,0 +1,99 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+
+static Sem ping;
+static Sem pong;
+
+#define ROUND_NUM 10000
+
+// ping-pong with a pair of semaphores, then the same with notifications
+
+static void run_task1(void* param){
+
+	u64 start;
+	u64 sem_ns;
+	u64 notify_ns;
+	u32 val;
+	u32 i;
+
+	param = param;
+
+	start = os_now_ns();
+
+	for(i = 0; i < ROUND_NUM; i ++) {
+
+		put_sem(&ping);
+		get_sem(&pong, 1);
+	}
+
+	sem_ns = os_now_ns() - start;
+
+	start = os_now_ns();
+
+	for(i = 0; i < ROUND_NUM; i ++) {
+
+		notify_task(&task2, 1, NOTIFY_INC);
+		wait_notify(&val, WAIT_FOREVER);
+	}
+
+	notify_ns = os_now_ns() - start;
+
+	vc_port_printf("%d round trips: sem %dns, notify %dns each\n", ROUND_NUM,
+		(u32) (sem_ns / ROUND_NUM), (u32) (notify_ns / ROUND_NUM));
+
+	// nobody notifies us now, so this times out after 5 ticks
+
+	if(TIMEOUT == wait_notify(&val, 5)) {
+
+		vc_port_printf("wait_notify timed out\n");
+	}
+
+	while(1) {
+
+		wait_notify(&val, WAIT_FOREVER);
+	}
+}
+
+static void run_task2(void* param){
+
+	u32 val;
+	u32 i;
+
+	param = param;
+
+	for(i = 0; i < ROUND_NUM; i ++) {
+
+		get_sem(&ping, 1);
+		put_sem(&pong);
+	}
+
+	while(1) {
+
+		wait_notify(&val, WAIT_FOREVER);
+		notify_task(&task1, val, NOTIFY_SET_BITS);
+	}
+}
+
+extern int global_test;
+
+void test_notify() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_sem(&ping, 0);
+		create_sem(&pong, 0);
+
+		create_task(&task1, run_task1, NULL, task1_stack, 1024);
+
+		create_task(&task2, run_task2, NULL, task2_stack, 1024);
+	}
+
+}
@@ -0,0 +1,96 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+static Task task3;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+static u8 task3_stack[1024];
+
+// short job every 5 ticks
+
+static void run_fast(void* param){
+
+	u32 job = 0;
+
+	param = param;
+
+	while(1) {
+
+		job ++;
+
+		if(!(job % 100)) {
+
+			vc_port_printf("fast: %d jobs, %d misses, jitter %dus, response %dus\n", job, task1.deadline_miss,
+				(u32) (task1.jitter_max / 1000), (u32) (task1.response_max / 1000));
+		}
+
+		wait_next_period();
+	}
+}
+
+// every 4th job runs 3 ticks into a 2 tick deadline and misses it
+
+static void run_slow(void* param){
+
+	u64 start;
+	u32 job = 0;
+
+	param = param;
+
+	while(1) {
+
+		job ++;
+
+		if(!(job % 4)) {
+
+			start = get_tick();
+
+			while(get_tick() < start + 3) {
+
+				yield();
+			}
+		}
+
+		if(!(job % 20)) {
+
+			vc_port_printf("slow: %d jobs, %d misses, jitter %dus, response %dus\n", job, task2.deadline_miss,
+				(u32) (task2.jitter_max / 1000), (u32) (task2.response_max / 1000));
+		}
+
+		wait_next_period();
+	}
+}
+
+// background load, it runs whenever both periodic tasks sleep
+
+static void run_load(void* param){
+
+	param = param;
+
+	while(1) {
+
+		yield();
+	}
+}
+
+extern int global_test;
+
+void test_period() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_periodic_task(&task1, run_fast, NULL, task1_stack, 1024, 5, 0);
+		set_task_prio(&task1, DEFAULT_PRIO - 2);
+
+		create_periodic_task(&task2, run_slow, NULL, task2_stack, 1024, 10, 2);
+		set_task_prio(&task2, DEFAULT_PRIO - 1);
+
+		create_task(&task3, run_load, NULL, task3_stack, 1024);
+	}
+
+}
@@ -0,0 +1,94 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+static Task task3;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+static u8 task3_stack[1024];
+
+typedef struct _Sample {
+
+	u32 seq;
+	u32 data[15];
+}Sample;
+
+static MsgPool pool;
+static u8 pool_mem[MSG_POOL_SIZE(sizeof(Sample), 4)];
+static Topic topic;
+
+static Subscriber sub1;
+static Subscriber sub2;
+static Msgbuf buf1;
+static Msgbuf buf2;
+static void* buf1_msg[4];
+static void* buf2_msg[4];
+
+// fill a sample in place and publish it once for both subscribers
+
+static void run_publisher(void* param){
+
+	Sample* p_sample;
+	u32 seq = 0;
+
+	param = param;
+
+	while(1) {
+
+		if(SUCCESS == alloc_msg(&pool, (void**) &p_sample)) {
+
+			p_sample-> seq = seq ++;
+			p_sample-> data[0] = seq * 10;
+
+			publish_msg(&topic, p_sample);
+		}
+
+		yield();
+	}
+}
+
+static void run_subscriber(void* param){
+
+	Msgbuf* p_msg_buf = (Msgbuf*) param;
+	Sample* p_sample;
+
+	while(1) {
+
+		get_msg_buf(p_msg_buf, (void**) &p_sample, 1);
+
+		if(!(p_sample-> seq % 1000)) {
+
+			vc_port_printf("%s got %d, %d blocks free, drops %d %d\n", p_msg_buf == &buf1 ? "sub1" : "sub2",
+				p_sample-> seq, pool.free_num, sub1.drop, sub2.drop);
+		}
+
+		release_msg(p_sample);
+	}
+}
+
+extern int global_test;
+
+void test_pubsub() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_msg_pool(&pool, pool_mem, sizeof(Sample), 4);
+		create_topic(&topic);
+
+		create_msg_buf(&buf1, buf1_msg, 4);
+		create_msg_buf(&buf2, buf2_msg, 4);
+		subscribe_topic(&topic, &sub1, &buf1);
+		subscribe_topic(&topic, &sub2, &buf2);
+
+		create_task(&task1, run_publisher, NULL, task1_stack, 1024);
+
+		create_task(&task2, run_subscriber, &buf1, task2_stack, 1024);
+
+		create_task(&task3, run_subscriber, &buf2, task3_stack, 1024);
+	}
+
+}
@@ -0,0 +1,128 @@
+
+#include <stdlib.h>
+#include "os.h"
+
+static Task task1;
+static Task task2;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+
+typedef struct _Item {
+
+	u32 seq;
+	u32 data[3];
+}Item;
+
+static Queue queue;
+static Item queue_buf[64];
+static Msgbuf buf;
+static void* buf_msg[64];
+
+#define ITEM_NUM 1000000
+
+// 16 byte items through a queue by value, then by pointer to malloc'ed
+// payloads through a msg buffer, both filled and drained in batches of 64
+
+static void run_task1(void* param){
+
+	Item item;
+	Item* p_item;
+	u64 start;
+	u64 queue_ns;
+	u64 buf_ns;
+	u32 sum;
+	u32 i;
+	u32 j;
+
+	param = param;
+	sum = 0;
+
+	start = os_now_ns();
+
+	for(i = 0; i < ITEM_NUM; i += 64) {
+
+		for(j = 0; j < 64; j ++) {
+
+			item.seq = i + j;
+			put_queue(&queue, &item);
+		}
+
+		for(j = 0; j < 64; j ++) {
+
+			get_queue(&queue, &item, 0);
+			sum += item.seq;
+		}
+	}
+
+	queue_ns = os_now_ns() - start;
+
+	start = os_now_ns();
+
+	for(i = 0; i < ITEM_NUM; i += 64) {
+
+		for(j = 0; j < 64; j ++) {
+
+			p_item = (Item*) malloc(sizeof(Item));
+			p_item-> seq = i + j;
+			put_msg_buf(&buf, p_item);
+		}
+
+		for(j = 0; j < 64; j ++) {
+
+			get_msg_buf(&buf, (void**) &p_item, 0);
+			sum += p_item-> seq;
+			free(p_item);
+		}
+	}
+
+	buf_ns = os_now_ns() - start;
+
+	vc_port_printf("per 1000 items: queue %dns, msg buf + malloc %dns (sum 0x%x)\n",
+		(u32) (queue_ns * 1000 / ITEM_NUM), (u32) (buf_ns * 1000 / ITEM_NUM), sum);
+
+	// now feed a waiting receiver, which gets a direct copy
+
+	for(i = 0; ; i ++) {
+
+		item.seq = i;
+		put_queue(&queue, &item);
+
+		yield();
+	}
+}
+
+static void run_task2(void* param){
+
+	Item item;
+
+	param = param;
+
+	while(1) {
+
+		get_queue(&queue, &item, 1);
+
+		if(!(item.seq % 10000)) {
+
+			vc_port_printf("got item %d\n", item.seq);
+		}
+	}
+}
+
+extern int global_test;
+
+void test_queue() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_queue(&queue, queue_buf, sizeof(Item), 64);
+		create_msg_buf(&buf, buf_msg, 64);
+
+		create_task(&task1, run_task1, NULL, task1_stack, 1024);
+
+		create_task(&task2, run_task2, NULL, task2_stack, 1024);
+	}
+
+}
@@ -0,0 +1,143 @@
+
+#include "os.h"
+
+#define READER_NUM 4
+
+static Task reader[READER_NUM];
+static Task writer;
+
+static u8 reader_stack[READER_NUM][1024];
+static u8 writer_stack[1024];
+
+static Mutex mutex;
+static Rwlock rw;
+
+static u32 table[16];
+static u32 mode;
+static u32 read_ops[2];
+static u32 write_ops[2];
+
+// readers hold the lock across a yield, as a long lookup would
+
+static void run_reader(void* param){
+
+	u32 use_rw;
+	u32 sum;
+	u32 i;
+
+	param = param;
+
+	while(1) {
+
+		use_rw = mode;
+
+		if(use_rw) {
+
+			get_rwlock_read(&rw, 1);
+
+		}else {
+
+			get_mutex(&mutex, 1);
+		}
+
+		for(sum = 0, i = 0; i < 16; i ++) {
+
+			sum += table[i];
+		}
+
+		yield();
+
+		if(use_rw) {
+
+			put_rwlock_read(&rw);
+
+		}else {
+
+			put_mutex(&mutex);
+		}
+
+		read_ops[use_rw] ++;
+	}
+}
+
+// update the table every 5 ticks, and switch between mutex and rwlock
+
+static void run_writer(void* param){
+
+	u64 start;
+	u32 use_rw;
+	u32 i;
+
+	param = param;
+
+	start = get_tick();
+
+	while(1) {
+
+		use_rw = mode;
+
+		if(use_rw) {
+
+			get_rwlock_write(&rw, 1);
+
+		}else {
+
+			get_mutex(&mutex, 1);
+		}
+
+		for(i = 0; i < 16; i ++) {
+
+			table[i] ++;
+		}
+
+		if(use_rw) {
+
+			put_rwlock_write(&rw);
+
+		}else {
+
+			put_mutex(&mutex);
+		}
+
+		write_ops[use_rw] ++;
+
+		if(get_tick() >= start + 200) {
+
+			start = get_tick();
+
+			vc_port_printf("%s: %d reads, %d writes in 200 ticks\n", use_rw ? "rwlock" : "mutex", read_ops[use_rw], write_ops[use_rw]);
+
+			read_ops[use_rw] = 0;
+			write_ops[use_rw] = 0;
+			mode = !use_rw;
+		}
+
+		wait_next_period();
+	}
+}
+
+extern int global_test;
+
+void test_rwlock() {
+
+	u32 i;
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		mode = 0;
+
+		create_mutex(&mutex);
+		create_rwlock(&rw);
+
+		for(i = 0; i < READER_NUM; i ++) {
+
+			create_task(&reader[i], run_reader, NULL, reader_stack[i], 1024);
+		}
+
+		create_periodic_task(&writer, run_writer, NULL, writer_stack, 1024, 5, 0);
+		set_task_prio(&writer, DEFAULT_PRIO - 1);
+	}
+
+}
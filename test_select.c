@@ -0,0 +1,120 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+
+static Mailbox box;
+static Msgbuf buf;
+static void* buf_msg[8];
+static Event event;
+static Sem sem;
+
+// one task serves all four objects without polling
+
+static void run_task1(void* param){
+
+	SelectItem item[4];
+	void* msg;
+	u32 data;
+	u32 index;
+
+	param = param;
+
+	item[0].obj = &box;
+	item[1].obj = &buf;
+	item[2].obj = &event;
+	item[2].event_val = 0x3;
+	item[3].obj = &sem;
+
+	while(1) {
+
+		if(TIMEOUT == select_wait(item, 4, &index, 30)) {
+
+			vc_port_printf("select timed out\n");
+
+			continue;
+		}
+
+		if(0 == index && SUCCESS == get_mail(&box, &msg, 0)) {
+
+			vc_port_printf("mail %d\n", (u32) msg);
+
+		}else if(1 == index && SUCCESS == get_msg_buf(&buf, &msg, 0)) {
+
+			vc_port_printf("msg buf %d\n", (u32) msg);
+
+		}else if(2 == index && SUCCESS == get_event(&event, OR_OPTION, 0x3, &data, 0)) {
+
+			vc_port_printf("event 0x%x\n", data);
+
+		}else if(3 == index && SUCCESS == get_sem(&sem, 0)) {
+
+			vc_port_printf("sem\n");
+		}
+	}
+}
+
+// feed one object after another, then go quiet so the select times out
+
+static void run_task2(void* param){
+
+	u64 start;
+	u32 i;
+
+	param = param;
+
+	for(i = 1; ; i ++) {
+
+		if(i % 16 < 12) {
+
+			if(0 == i % 4) {
+
+				put_mail(&box, (void*) i);
+
+			}else if(1 == i % 4) {
+
+				put_msg_buf(&buf, (void*) i);
+
+			}else if(2 == i % 4) {
+
+				put_event(&event, (i & 4) ? 0x2 : 0x1);
+
+			}else {
+
+				put_sem(&sem);
+			}
+		}
+
+		start = get_tick();
+
+		while(get_tick() < start + 10) {
+
+			yield();
+		}
+	}
+}
+
+extern int global_test;
+
+void test_select() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_mail(&box, NULL);
+		create_msg_buf(&buf, buf_msg, 8);
+		create_event(&event, 0);
+		create_sem(&sem, 0);
+
+		create_task(&task1, run_task1, NULL, task1_stack, 1024);
+		set_task_prio(&task1, DEFAULT_PRIO - 1);
+
+		create_task(&task2, run_task2, NULL, task2_stack, 1024);
+	}
+
+}
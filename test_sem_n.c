@@ -0,0 +1,160 @@
+
+#include "os.h"
+
+#define WAITER_NUM 3
+#define LOOP_NUM   100000
+
+static Task task1;
+static Task big;
+static Task small;
+static Task waiter[WAITER_NUM];
+
+static u8 task1_stack[1024];
+static u8 big_stack[1024];
+static u8 small_stack[1024];
+static u8 waiter_stack[WAITER_NUM][1024];
+
+static Sem credit;
+static Sem gate;
+
+static u32 big_got;
+static u32 small_got;
+static u32 flushed;
+
+// 16 credits one by one and at once, then the order of waiters, the max
+// count and a flush
+
+static void run_task1(void* param){
+
+	u64 start;
+	u64 one_ns;
+	u64 n_ns;
+	u32 val;
+	u32 i;
+	u32 j;
+
+	param = param;
+
+	start = os_now_ns();
+
+	for(i = 0; i < LOOP_NUM; i ++) {
+
+		for(j = 0; j < 16; j ++) {
+
+			get_sem(&credit, 0);
+		}
+
+		for(j = 0; j < 16; j ++) {
+
+			put_sem(&credit);
+		}
+	}
+
+	one_ns = os_now_ns() - start;
+
+	start = os_now_ns();
+
+	for(i = 0; i < LOOP_NUM; i ++) {
+
+		get_sem_n(&credit, 16, 0);
+		put_sem_n(&credit, 16);
+	}
+
+	n_ns = os_now_ns() - start;
+
+	vc_port_printf("16 credits: one by one %dns, get_sem_n %dns\n",
+		(u32) (one_ns / LOOP_NUM), (u32) (n_ns / LOOP_NUM));
+
+	vc_port_printf("put on a full sem: %s\n", SEM_FULL == put_sem(&credit) ? "SEM_FULL" : "accepted");
+
+	// big waits for 16 first, small for 1 after it
+
+	get_sem_n(&credit, 64, 0);
+	yield();
+
+	put_sem_n(&credit, 8);
+	yield();
+
+	vc_port_printf("8 credits back: big %d, small %d\n", big_got, small_got);
+
+	put_sem_n(&credit, 8);
+	yield();
+
+	vc_port_printf("16 credits back: big %d, small %d\n", big_got, small_got);
+
+	put_sem(&credit);
+	yield();
+
+	vc_port_printf("1 credit back: big %d, small %d\n", big_got, small_got);
+
+	flush_sem(&gate);
+	yield();
+
+	vc_port_printf("flush woke %d waiters\n", flushed);
+
+	wait_notify(&val, WAIT_FOREVER);
+}
+
+static void run_big(void* param){
+
+	param = param;
+
+	while(1) {
+
+		get_sem_n(&credit, 16, 1);
+		big_got ++;
+	}
+}
+
+static void run_small(void* param){
+
+	param = param;
+
+	while(1) {
+
+		get_sem(&credit, 1);
+		small_got ++;
+	}
+}
+
+static void run_waiter(void* param){
+
+	param = param;
+
+	while(1) {
+
+		if(SEM_FLUSHED == get_sem(&gate, 1)) {
+
+			flushed ++;
+		}
+	}
+}
+
+extern int global_test;
+
+void test_sem_n() {
+
+	u32 i;
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_sem(&credit, 64);
+		set_sem_max(&credit, 64);
+
+		create_sem(&gate, 0);
+
+		create_task(&task1, run_task1, NULL, task1_stack, 1024);
+
+		create_task(&big, run_big, NULL, big_stack, 1024);
+
+		create_task(&small, run_small, NULL, small_stack, 1024);
+
+		for(i = 0; i < WAITER_NUM; i ++) {
+
+			create_task(&waiter[i], run_waiter, NULL, waiter_stack[i], 1024);
+		}
+	}
+
+}
@@ -0,0 +1,90 @@
+
+#include "os.h"
+
+// arm SLACK_TIMER_NUM one-shot timers with jittered deadlines, once with no
+// slack and once with SLACK_TICKS of slack, and count timer task wakeups
+
+#define SLACK_TIMER_NUM 10000
+#define SLACK_JITTER    500
+#define SLACK_TICKS     20
+
+static Task task;
+
+static u8 stack[1024];
+
+static Timer timer[SLACK_TIMER_NUM];
+static u32 fired;
+static u32 seed;
+
+extern u32 g_timer_wakeup;
+
+static void timer_func(void* param){
+
+	param = param;
+
+	fired ++;
+}
+
+static u32 jitter(){
+
+	seed = seed * 1103515245 + 12345;
+
+	return (seed >> 16) % SLACK_JITTER;
+}
+
+static u32 run_round(u32 slack){
+
+	u32 wakeup;
+	u32 i;
+
+	fired = 0;
+	seed = 1;
+
+	for(i = 0; i < SLACK_TIMER_NUM; i ++) {
+
+		create_timer(&timer[i], 10 + jitter(), timer_func, NULL);
+		set_timer_slack(&timer[i], slack);
+		activate_timer(&timer[i]);
+	}
+
+	wakeup = g_timer_wakeup;
+
+	while(fired < SLACK_TIMER_NUM) {
+
+		yield();
+	}
+
+	return g_timer_wakeup - wakeup;
+}
+
+static void run_task(void* param){
+
+	u32 strict;
+	u32 loose;
+
+	param = param;
+
+	strict = run_round(0);
+	loose = run_round(SLACK_TICKS);
+
+	vc_port_printf("%d timers, %d wakeups without slack, %d with %d ticks slack, %d saved\n",
+		SLACK_TIMER_NUM, strict, loose, SLACK_TICKS, strict - loose);
+
+	while(1) {
+		yield();
+	}
+}
+
+extern int global_test;
+
+void test_slack() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_task(&task, run_task, NULL, stack, 1024);
+	}
+
+}
+
@@ -0,0 +1,122 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+
+static Sem start_sem;
+static Stream stream;
+static u8 stream_buf[4096];
+
+static u8 chunk[1024];
+static u8 data[1024];
+
+#define BYTE_NUM (16 * 1024 * 1024)
+
+// push BYTE_NUM bytes through the stream in chunks of each size, writing
+// and reading back to back so only the copy and index work is timed
+
+static void run_task1(void* param){
+
+	static const u32 chunk_size[] = {1, 16, 64, 256, 1024};
+	void* p_buf;
+	u64 start;
+	u64 ns;
+	u32 len;
+	u32 done;
+	u32 i;
+	u32 n;
+
+	param = param;
+
+	for(i = 0; i < sizeof(chunk_size) / sizeof(chunk_size[0]); i ++) {
+
+		start = os_now_ns();
+
+		for(done = 0; done < BYTE_NUM; done += chunk_size[i]) {
+
+			write_stream(&stream, chunk, chunk_size[i], &len);
+			read_stream(&stream, data, chunk_size[i], &len, 0);
+		}
+
+		ns = os_now_ns() - start;
+
+		vc_port_printf("chunk %d: %d MB/s\n", chunk_size[i], (u32) ((u64) BYTE_NUM * 1000 / ns));
+	}
+
+	// the same with reserve/commit and peek/consume, nothing is copied
+
+	start = os_now_ns();
+
+	for(done = 0; done < BYTE_NUM; done += n) {
+
+		reserve_stream(&stream, &p_buf, &n);
+		if(n > 256) {
+
+			n = 256;
+		}
+
+		commit_stream(&stream, n);
+
+		peek_stream(&stream, &p_buf, &len, 0);
+		consume_stream(&stream, len);
+	}
+
+	ns = os_now_ns() - start;
+
+	vc_port_printf("reserve/commit 256: %d MB/s\n", (u32) ((u64) BYTE_NUM * 1000 / ns));
+
+	// now trickle single bytes to a reader sleeping on the trigger level
+
+	put_sem(&start_sem);
+
+	for(i = 0; ; i ++) {
+
+		chunk[0] = (u8) i;
+		write_stream(&stream, chunk, 1, &len);
+
+		start = get_tick();
+
+		while(get_tick() < start + 1) {
+
+			yield();
+		}
+	}
+}
+
+static void run_task2(void* param){
+
+	u32 len;
+
+	param = param;
+
+	get_sem(&start_sem, 1);
+
+	while(1) {
+
+		read_stream(&stream, data, sizeof(data), &len, 1);
+
+		vc_port_printf("reader woke with %d bytes at tick %d\n", len, (u32) get_tick());
+	}
+}
+
+extern int global_test;
+
+void test_stream() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_sem(&start_sem, 0);
+		create_stream(&stream, stream_buf, sizeof(stream_buf), 32);
+
+		create_task(&task1, run_task1, NULL, task1_stack, 1024);
+
+		create_task(&task2, run_task2, NULL, task2_stack, 1024);
+	}
+
+}
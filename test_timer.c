@@ -6,6 +6,14 @@ static Task task;;
 static u8 stack[1024];
 
 static Timer timer;
+static Timer periodic_timer;
+static Timer hard_timer;
+static Timer slow_timer;
+
+static TimerService service;
+static u8 service_stack[1024];
+
+static Sem hard_sem;
 
 static void timer_func(void* param){
 
@@ -16,6 +24,37 @@ static void timer_func(void* param){
 	activate_timer(&timer);
 }
 
+static void periodic_func(void* param){
+
+	param = param;
+	
+	vc_port_printf("periodic %d %d\t", periodic_timer.overrun, periodic_timer.max_late);
+}
+
+// runs in timer_isr_func, so only isr safe calls
+
+static void hard_func(void* param){
+
+	param = param;
+
+	put_sem(&hard_sem);
+}
+
+// a slow callback only delays its own service task
+
+static void slow_func(void* param){
+
+	volatile u32 i;
+
+	param = param;
+
+	for(i = 0; i < 20000000; i ++) {
+
+	}
+
+	vc_port_printf("slow %dus\t", (u32) (slow_timer.exec_max / 1000));
+}
+
 static void run_task(void* param){
 
 	param = param;
@@ -23,8 +62,34 @@ static void run_task(void* param){
 	create_timer(&timer, 50, timer_func, NULL);
 	
 	activate_timer(&timer);
+
+	create_periodic_timer(&periodic_timer, 20, 20, periodic_func, NULL);
+
+	activate_timer(&periodic_timer);
+
+	create_sem(&hard_sem, 0);
+
+	create_periodic_timer(&hard_timer, 1, 100, hard_func, NULL);
+
+	set_timer_hard(&hard_timer, 1);
+
+	activate_timer(&hard_timer);
+
+	create_timer_service(&service, DEFAULT_PRIO - 1, service_stack, 1024);
+
+	create_periodic_timer(&slow_timer, 30, 30, slow_func, NULL);
+
+	set_timer_service(&slow_timer, &service);
+
+	activate_timer(&slow_timer);
 	
 	while(1) {
+
+		if(SUCCESS == get_sem(&hard_sem, 0)) {
+
+			vc_port_printf("hard\t");
+		}
+
 		yield();
 	}
 }
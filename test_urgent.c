@@ -0,0 +1,104 @@
+
+#include "os.h"
+
+static Task task1;
+static Task task2;
+
+static u8 task1_stack[1024];
+static u8 task2_stack[1024];
+
+static Msgbuf buf;
+static void* buf_msg[256];
+
+static PrioMsgbuf prio_buf;
+static MsgNode prio_node[256];
+
+#define URGENT ((void*) 0xffff)
+
+// queue a backlog of bulk data, then an urgent message behind it
+
+static void run_task1(void* param){
+
+	u32 i;
+
+	param = param;
+
+	// let task2 block in select_wait() first
+
+	yield();
+
+	while(1) {
+
+		for(i = 1; i <= 200; i ++) {
+
+			put_msg_buf(&buf, (void*) i);
+			put_prio_msg_buf(&prio_buf, (void*) i, MSG_PRIO_NUM - 1);
+		}
+
+		put_msg_buf_front(&buf, URGENT);
+		put_prio_msg_buf(&prio_buf, URGENT, 0);
+
+		while(buf.count || prio_buf.count) {
+
+			yield();
+		}
+	}
+}
+
+// the urgent message must come out first although it was queued last
+
+static void run_task2(void* param){
+
+	SelectItem item;
+	void* msg;
+	u32 index;
+
+	param = param;
+
+	// a prio buf can be selected like a plain msg buf
+
+	item.obj = &prio_buf;
+
+	if(SUCCESS == select_wait(&item, 1, &index, WAIT_FOREVER)) {
+
+		vc_port_printf("select woke on the prio buf\n");
+	}
+
+	while(1) {
+
+		get_msg_buf(&buf, &msg, 1);
+
+		if(URGENT != msg) {
+
+			continue;
+		}
+
+		vc_port_printf("urgent ahead of %d queued msgs, ", buf.count);
+
+		get_prio_msg_buf(&prio_buf, &msg, 0);
+
+		vc_port_printf("prio buf gave %s first\n", URGENT == msg ? "urgent" : "bulk");
+
+		while(SUCCESS == get_prio_msg_buf(&prio_buf, &msg, 0)) {
+
+		}
+	}
+}
+
+extern int global_test;
+
+void test_urgent() {
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_msg_buf(&buf, buf_msg, 256);
+		create_prio_msg_buf(&prio_buf, prio_node, 256);
+
+		create_task(&task1, run_task1, NULL, task1_stack, 1024);
+
+		create_task(&task2, run_task2, NULL, task2_stack, 1024);
+	}
+
+}
@@ -0,0 +1,142 @@
+
+#include "os.h"
+
+#define WORKER_NUM 4
+
+static Task task1;
+static Task worker[WORKER_NUM];
+static Task buf_worker[WORKER_NUM];
+
+static u8 task1_stack[1024];
+static u8 worker_stack[WORKER_NUM][1024];
+static u8 buf_worker_stack[WORKER_NUM][1024];
+
+static Workqueue wq;
+static WorkItem wq_buf[64];
+static DelayedWork tick_work;
+
+static Msgbuf buf;
+static void* buf_msg[64];
+
+static u32 wq_sum;
+static u32 buf_sum;
+static u32 buf_wakeups;
+static u32 delayed;
+
+extern void (*simulated_interrupt_fun)();
+
+static void count_work(void* param){
+
+	wq_sum += (u32) param;
+}
+
+// runs every 50 ticks, submitted again from the work itself
+
+static void delayed_work(void* param){
+
+	param = param;
+
+	delayed ++;
+
+	submit_delayed_work(&tick_work, 50);
+}
+
+// the hand-rolled way, worker tasks sleeping on a msg buffer
+
+static void run_buf_worker(void* param){
+
+	void* msg;
+
+	param = param;
+
+	while(1) {
+
+		if(SUCCESS != get_msg_buf(&buf, &msg, 0)) {
+
+			get_msg_buf(&buf, &msg, 1);
+			buf_wakeups ++;
+		}
+
+		buf_sum += (u32) msg;
+	}
+}
+
+// simulated device interrupt, one item per tick to both
+
+static void work_isr(){
+
+	submit_work(&wq, count_work, (void*) 1);
+	put_msg_buf(&buf, (void*) 1);
+}
+
+// a burst of 16 items every tick on top of the interrupt, to the work
+// queue and to the msg buffer
+
+static void run_task1(void* param){
+
+	WorkStat stat;
+	u64 start;
+	u32 val;
+	u32 i;
+
+	param = param;
+
+	simulated_interrupt_fun = work_isr;
+
+	submit_delayed_work(&tick_work, 50);
+
+	start = get_tick();
+
+	while(1) {
+
+		for(i = 0; i < 16; i ++) {
+
+			submit_work(&wq, count_work, (void*) 1);
+			put_msg_buf(&buf, (void*) 1);
+		}
+
+		wait_notify(&val, 1);
+
+		if(get_tick() >= start + 200) {
+
+			start = get_tick();
+
+			get_workqueue_stat(&wq, &stat, 1);
+
+			vc_port_printf("work queue: %d done, %d wakeups, depth max %d, latency avg %dns max %dns, delayed %d\n",
+				stat.done, stat.wakeups, stat.depth_max, (u32) stat.latency_avg, (u32) stat.latency_max, delayed);
+
+			vc_port_printf("msg buffer: %d done, %d wakeups\n", buf_sum, buf_wakeups);
+
+			buf_sum = 0;
+			buf_wakeups = 0;
+		}
+	}
+}
+
+extern int global_test;
+
+void test_work() {
+
+	u32 i;
+
+	if(!global_test) {
+
+		global_test = 1;
+
+		create_workqueue(&wq, wq_buf, 64, 8);
+		create_delayed_work(&tick_work, &wq, delayed_work, NULL);
+
+		create_msg_buf(&buf, buf_msg, 64);
+
+		for(i = 0; i < WORKER_NUM; i ++) {
+
+			add_worker(&wq, &worker[i], DEFAULT_PRIO, worker_stack[i], 1024);
+
+			create_task(&buf_worker[i], run_buf_worker, NULL, buf_worker_stack[i], 1024);
+		}
+
+		create_task(&task1, run_task1, NULL, task1_stack, 1024);
+	}
+
+}